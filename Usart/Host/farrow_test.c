@@ -0,0 +1,102 @@
+/*
+ * Host accuracy test of Farrow resampler.
+ *
+ * Sine is resampled over sweep of ratios and frequencies in blocks, every output is
+ * compared with ideal fractional delay, the sine evaluated at exact read position.
+ * SNR and maximal error in LSB are reported, test fails below limits.
+ */
+
+#include <stdio.h>
+#include "farrow.h"
+
+DWT_Type HOST_Dwt;
+
+#define TEST_BLOCK					64
+#define TEST_BLOCKS					64
+#define TEST_AMPLITUDE				16000.0
+
+/* Outputs touching zero history at start are skipped */
+#define TEST_SKIP					8
+
+typedef struct {
+	double Frequency;   /* Cycles per input sample */
+	double MinSnr;      /* dB */
+	double MaxError;    /* LSB */
+} TEST_Limit_t;
+
+/* Cubic Lagrange error grows with frequency, pulse and motion signals are heavily oversampled */
+static const TEST_Limit_t TEST_Limits[] = {
+	{0.005, 80.0, 2.0},
+	{0.02,  80.0, 2.0},
+	{0.05,  70.0, 6.0},
+	{0.1,   50.0, 64.0}
+};
+
+static const double TEST_Ratios[] = {0.5, 0.75, 0.999, 0.9999, 1.0, 1.0001, 1.001, 1.25, 1.5, 2.0};
+static const double TEST_Ppm[] = {-500.0, -50.0, 50.0, 500.0};
+
+static q15_t TEST_State[FARROW_HISTORY + TEST_BLOCK];
+static q15_t TEST_Out[2 * TEST_BLOCK + 2];
+
+static int TEST_Run(const char* name, double ratio, double ppm, int usePpm, const TEST_Limit_t* limit) {
+	FARROW_t f;
+	q15_t src[TEST_BLOCK];
+	double w = 2.0 * 3.14159265358979323846 * limit->Frequency;
+	double pos = 0.0, step, ref, err, sig = 0.0, noise = 0.0, maxErr = 0.0, snr;
+	uint32_t b, i, n, k = 0;
+	int ok;
+
+	FARROW_Init(&f, TEST_State, TEST_BLOCK);
+	if (usePpm) {
+		FARROW_SetDriftPpm(&f, (float32_t)ppm);
+	} else {
+		FARROW_SetRatio(&f, (float32_t)ratio);
+	}
+	/* Reference follows fixed point step actually used */
+	step = (double)f.Step / 4294967296.0;
+
+	for (b = 0; b < TEST_BLOCKS; b++) {
+		for (i = 0; i < TEST_BLOCK; i++) {
+			src[i] = (q15_t)lrint(TEST_AMPLITUDE * sin(w * (b * TEST_BLOCK + i)));
+		}
+		n = FARROW_Process_q15(&f, src, TEST_Out, TEST_BLOCK);
+		for (i = 0; i < n; i++, k++, pos += step) {
+			if (k < TEST_SKIP) {
+				continue;
+			}
+			/* Read position is FARROW_DELAY input samples behind input index */
+			ref = TEST_AMPLITUDE * sin(w * (pos - FARROW_DELAY));
+			err = TEST_Out[i] - ref;
+			sig += ref * ref;
+			noise += err * err;
+			if (fabs(err) > maxErr) {
+				maxErr = fabs(err);
+			}
+		}
+	}
+
+	snr = 10.0 * log10(sig / (noise > 0.0 ? noise : 1e-12));
+	ok = snr >= limit->MinSnr && maxErr <= limit->MaxError;
+	printf("%-5s %-5s %10.4f  %7u  %6.1f dB  %6.1f LSB  %s\n", name, usePpm ? "ppm" : "ratio",
+		usePpm ? ppm : ratio, k, snr, maxErr, ok ? "ok" : "FAIL");
+	return ok;
+}
+
+int main(void) {
+	uint32_t i, j, failed = 0;
+	char name[8];
+
+	printf("freq  type       value  outputs      SNR      max err\n");
+	for (j = 0; j < sizeof(TEST_Limits) / sizeof(TEST_Limits[0]); j++) {
+		snprintf(name, sizeof(name), "%.3f", TEST_Limits[j].Frequency);
+		for (i = 0; i < sizeof(TEST_Ratios) / sizeof(TEST_Ratios[0]); i++) {
+			failed += !TEST_Run(name, TEST_Ratios[i], 0.0, 0, &TEST_Limits[j]);
+		}
+		for (i = 0; i < sizeof(TEST_Ppm) / sizeof(TEST_Ppm[0]); i++) {
+			failed += !TEST_Run(name, 0.0, TEST_Ppm[i], 1, &TEST_Limits[j]);
+		}
+	}
+
+	printf(failed ? "farrow: %u cases FAILED\n" : "farrow: all cases passed\n", failed);
+	return failed ? 1 : 0;
+}
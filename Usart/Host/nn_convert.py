@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+"""
+Converts trained network from JSON to flash-resident q7 model for nn.c.
+
+Input JSON:
+
+  {
+    "name": "activity",
+    "input": {"length": 32, "channels": 3, "frac": 7},
+    "layers": [
+      {"type": "conv1d", "filters": 8, "kernel": 5, "stride": 1, "activation": "relu",
+       "weights": [[[w, ...], ...], ...], "bias": [b, ...]},
+      {"type": "maxpool1d", "kernel": 2},
+      {"type": "dense", "units": 4, "activation": "none",
+       "weights": [[w, ...], ...], "bias": [b, ...]}
+    ],
+    "calibration": [[x, ...], ...]
+  }
+
+Float weights are conv1d [filter][k][channel] and dense [out][in], dense input is the
+previous tensor flattened as x[t * channels + c]. Input "frac" is number of fractional
+bits of q7 input. Calibration inputs are flat float lists in the same order; without
+them, random inputs over full input range are used.
+
+Every tensor gets power of two scale. Weights and bias take the largest number of
+fractional bits which fits q7, outputs take it from largest calibrated activation.
+Accumulator has input + weight fractional bits, which gives BiasShift and OutShift.
+
+Output is <out>.c with constant tables and NN_Model_t <name>_model, and <out>.h.
+With --vectors, header with test inputs and expected outputs of nn_ref.py is written.
+"""
+
+import argparse
+import json
+import math
+import os
+import random
+import sys
+
+import nn_ref
+
+TYPES = {"dense": nn_ref.DENSE, "conv1d": nn_ref.CONV1D, "maxpool1d": nn_ref.MAXPOOL1D}
+ACTIVATIONS = {"none": nn_ref.ACT_NONE, "relu": nn_ref.ACT_RELU}
+TYPE_NAMES = {nn_ref.DENSE: "NN_Layer_Dense", nn_ref.CONV1D: "NN_Layer_Conv1d",
+              nn_ref.MAXPOOL1D: "NN_Layer_MaxPool1d"}
+ACT_NAMES = {nn_ref.ACT_NONE: "NN_Activation_None", nn_ref.ACT_RELU: "NN_Activation_Relu"}
+
+# Limits of NN_Layer_t fields and nn.c arithmetic
+MAX_LAYERS = 16
+MAX_SHIFT = 31
+
+
+def fail(msg):
+    sys.exit("nn_convert: " + msg)
+
+
+def flatten(v):
+    if isinstance(v, list):
+        return [y for x in v for y in flatten(x)]
+    return [float(v)]
+
+
+def frac_bits(maxabs):
+    """Largest number of fractional bits with maxabs still in q7."""
+    if maxabs <= 0.0:
+        return 7
+    return math.floor(math.log2(127.0 / maxabs))
+
+
+def quantize(values, frac):
+    scale = 2.0 ** frac
+    return [max(-128, min(127, int(round(v * scale)))) for v in values]
+
+
+def float_layer(layer, x):
+    """Float forward pass of one layer for calibration."""
+    if layer["type"] == nn_ref.MAXPOOL1D:
+        return nn_ref.maxpool1d(layer, x)
+    w, b = layer["fweights"], layer["fbias"]
+    if layer["type"] == nn_ref.DENSE:
+        n = layer["in_len"]
+        y = [sum(x[i] * w[o * n + i] for i in range(n)) + b[o] for o in range(layer["out_len"])]
+    else:
+        window = layer["kernel"] * layer["in_ch"]
+        step = layer["stride"] * layer["in_ch"]
+        y = []
+        for t in range(layer["out_len"]):
+            for f in range(layer["out_ch"]):
+                y.append(sum(x[t * step + i] * w[f * window + i] for i in range(window)) + b[f])
+    if layer["activation"] == nn_ref.ACT_RELU:
+        y = [max(0.0, v) for v in y]
+    return y
+
+
+def build(spec, seed):
+    """Shapes, calibration and quantization of all layers."""
+    inp = spec["input"]
+    length, ch, in_frac = inp["length"], inp.get("channels", 1), inp.get("frac", 7)
+    layers = []
+
+    for i, src in enumerate(spec["layers"]):
+        kind = TYPES.get(src["type"])
+        if kind is None:
+            fail("layer %d: unknown type %s" % (i, src["type"]))
+        layer = {"type": kind, "activation": ACTIVATIONS[src.get("activation", "none")],
+                 "in_len": length, "in_ch": ch, "kernel": 0, "stride": 0,
+                 "bias_shift": 0, "out_shift": 0, "weights": None, "bias": None}
+        if kind == nn_ref.DENSE:
+            layer["in_len"], layer["in_ch"] = length * ch, 1
+            layer["out_len"], layer["out_ch"] = src["units"], 1
+            expect = src["units"] * length * ch
+        elif kind == nn_ref.CONV1D:
+            k, s = src["kernel"], src.get("stride", 1)
+            if k > length:
+                fail("layer %d: kernel longer than input" % i)
+            layer["kernel"], layer["stride"] = k, s
+            layer["out_len"], layer["out_ch"] = (length - k) // s + 1, src["filters"]
+            expect = src["filters"] * k * ch
+        else:
+            k = src["kernel"]
+            layer["kernel"], layer["stride"] = k, k
+            layer["out_len"], layer["out_ch"] = length // k, ch
+            expect = 0
+        if kind != nn_ref.MAXPOOL1D:
+            layer["fweights"] = flatten(src["weights"])
+            layer["fbias"] = flatten(src["bias"])
+            outputs = layer["out_len"] if kind == nn_ref.DENSE else layer["out_ch"]
+            if len(layer["fweights"]) != expect or len(layer["fbias"]) != outputs:
+                fail("layer %d: wrong number of weights or biases" % i)
+        layers.append(layer)
+        length, ch = layer["out_len"], layer["out_ch"]
+
+    if not 0 < len(layers) <= MAX_LAYERS:
+        fail("1 to %d layers are supported" % MAX_LAYERS)
+
+    # Calibration with float model
+    size = inp["length"] * inp.get("channels", 1)
+    calib = spec.get("calibration")
+    if not calib:
+        rng = random.Random(seed)
+        full = 128.0 / 2.0 ** in_frac
+        calib = [[rng.uniform(-full, full) for _ in range(size)] for _ in range(32)]
+    peaks = [0.0] * len(layers)
+    for x in calib:
+        x = [float(v) for v in flatten(x)]
+        if len(x) != size:
+            fail("calibration input has %d values, %d expected" % (len(x), size))
+        for i, layer in enumerate(layers):
+            x = float_layer(layer, x)
+            peaks[i] = max(peaks[i], max(abs(v) for v in x))
+
+    # Power of two scales
+    frac = in_frac
+    for i, layer in enumerate(layers):
+        if layer["type"] == nn_ref.MAXPOOL1D:
+            layer["frac"] = frac
+            continue
+        w_frac = frac_bits(max(abs(v) for v in layer["fweights"]))
+        acc_frac = frac + w_frac
+        b_frac = min(frac_bits(max(abs(v) for v in layer["fbias"])), acc_frac)
+        out_frac = min(frac_bits(peaks[i]), acc_frac)
+        if acc_frac - b_frac > MAX_SHIFT or acc_frac - out_frac > MAX_SHIFT:
+            fail("layer %d: scale out of range" % i)
+        layer["weights"] = quantize(layer["fweights"], w_frac)
+        layer["bias"] = quantize(layer["fbias"], b_frac)
+        layer["bias_shift"] = acc_frac - b_frac
+        layer["out_shift"] = acc_frac - out_frac
+        layer["frac"] = frac = out_frac
+
+    return layers, size, in_frac
+
+
+def c_array(name, values):
+    rows = [", ".join("%d" % v for v in values[i:i + 16]) for i in range(0, len(values), 16)]
+    return "static const q7_t %s[%d] = {\n\t%s\n};\n" % (name, len(values), ",\n\t".join(rows))
+
+
+def write_model(out, name, source, layers, size, in_frac):
+    max_tensor = max([size] + [l["out_len"] * l["out_ch"] for l in layers])
+    guard = name.upper() + "_MODEL_H"
+    base = os.path.basename(out)
+
+    with open(out + ".h", "w") as f:
+        f.write("/* Generated by nn_convert.py from %s, do not edit */\n" % source)
+        f.write("#ifndef %s\n#define %s 100\n\n#include \"nn.h\"\n\n" % (guard, guard))
+        f.write("/* Fractional bits of input and output tensor */\n")
+        f.write("#define %s_INPUT_FRAC\t\t%d\n" % (name.upper(), in_frac))
+        f.write("#define %s_OUTPUT_FRAC\t\t%d\n\n" % (name.upper(), layers[-1]["frac"]))
+        f.write("/* Arena of 2 * %d bytes is needed */\n" % ((max_tensor + 3) & ~3))
+        f.write("extern const NN_Model_t %s_model;\n\n#endif\n" % name)
+
+    with open(out + ".c", "w") as f:
+        f.write("/* Generated by nn_convert.py from %s, do not edit */\n" % source)
+        f.write("#include \"%s.h\"\n\n" % base)
+        entries = []
+        for i, l in enumerate(layers):
+            w = b = "NULL"
+            if l["weights"] is not None:
+                w, b = "%s_l%d_w" % (name, i), "%s_l%d_b" % (name, i)
+                f.write(c_array(w, l["weights"]))
+                f.write(c_array(b, l["bias"]))
+                f.write("\n")
+            entries.append("\t{%s, %s, %d, %d, %d, %d, %d, %d, %d, %d, %s, %s}" % (
+                TYPE_NAMES[l["type"]], ACT_NAMES[l["activation"]], l["in_len"], l["in_ch"],
+                l["out_len"], l["out_ch"], l["kernel"], l["stride"], l["bias_shift"],
+                l["out_shift"], w, b))
+        f.write("static const NN_Layer_t %s_layers[%d] = {\n%s\n};\n\n" % (name, len(layers), ",\n".join(entries)))
+        f.write("const NN_Model_t %s_model = {NN_MAGIC, %d, %d, %d, %s_layers};\n" % (
+            name, len(layers), size, max_tensor, name))
+
+
+def write_vectors(path, name, layers, size, count, seed):
+    """Random full range q7 inputs and outputs of integer reference."""
+    rng = random.Random(seed)
+    inputs = [[rng.randint(-128, 127) for _ in range(size)] for _ in range(count)]
+    # Extreme inputs reach saturation in every layer
+    inputs.append([127] * size)
+    inputs.append([-128] * size)
+    outputs = [nn_ref.run(layers, x) for x in inputs]
+
+    with open(path, "w") as f:
+        f.write("/* Generated by nn_convert.py, expected outputs of nn_ref.py */\n")
+        f.write("#define NN_TEST_MODEL\t\t\t%s_model\n" % name)
+        f.write("#define NN_TEST_COUNT\t\t\t%d\n" % len(inputs))
+        f.write("#define NN_TEST_INPUT_SIZE\t\t%d\n" % size)
+        f.write("#define NN_TEST_OUTPUT_SIZE\t\t%d\n\n" % len(outputs[0]))
+        for label, rows in (("Input", inputs), ("Output", outputs)):
+            f.write("static const q7_t NN_Test%s[NN_TEST_COUNT][NN_TEST_%s_SIZE] = {\n" % (label, label.upper()))
+            f.write(",\n".join("\t{%s}" % ", ".join("%d" % v for v in r) for r in rows))
+            f.write("\n};\n\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert network JSON to nn.c model tables")
+    parser.add_argument("model", help="network description in JSON")
+    parser.add_argument("-o", "--out", required=True, help="output path without extension")
+    parser.add_argument("--vectors", help="write test vectors header to this path")
+    parser.add_argument("--count", type=int, default=64, help="number of random test vectors")
+    parser.add_argument("--seed", type=int, default=1, help="seed of random inputs")
+    args = parser.parse_args()
+
+    with open(args.model) as f:
+        spec = json.load(f)
+    name = spec.get("name", "nn")
+    layers, size, in_frac = build(spec, args.seed)
+    write_model(args.out, name, os.path.basename(args.model), layers, size, in_frac)
+    if args.vectors:
+        write_vectors(args.vectors, name, layers, size, args.count, args.seed)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,76 @@
+"""
+Bit-exact integer reference of nn.c inference, independent of device code.
+
+Layers are dictionaries with the fields of NN_Layer_t: type, activation, in_len,
+in_ch, out_len, out_ch, kernel, stride, bias_shift, out_shift, weights, bias.
+Tensors are flat lists of q7 integers interleaved by channel, x[t * channels + c].
+"""
+
+DENSE = 0
+CONV1D = 1
+MAXPOOL1D = 2
+
+ACT_NONE = 0
+ACT_RELU = 1
+
+
+def sat8(v):
+    return max(-128, min(127, v))
+
+
+def output(layer, acc, ch):
+    """Bias, rounding, shift, saturation and activation of one accumulator."""
+    acc += layer["bias"][ch] << layer["bias_shift"]
+    shift = layer["out_shift"]
+    if shift:
+        # Arithmetic shift, as on Cortex-M
+        acc = (acc + (1 << (shift - 1))) >> shift
+    acc = sat8(acc)
+    if layer["activation"] == ACT_RELU and acc < 0:
+        acc = 0
+    return acc
+
+
+def dense(layer, x):
+    w = layer["weights"]
+    n = layer["in_len"]
+    out = []
+    for o in range(layer["out_len"]):
+        acc = sum(x[i] * w[o * n + i] for i in range(n))
+        out.append(output(layer, acc, o))
+    return out
+
+
+def conv1d(layer, x):
+    w = layer["weights"]
+    window = layer["kernel"] * layer["in_ch"]
+    step = layer["stride"] * layer["in_ch"]
+    out = []
+    for t in range(layer["out_len"]):
+        base = t * step
+        for f in range(layer["out_ch"]):
+            acc = sum(x[base + i] * w[f * window + i] for i in range(window))
+            out.append(output(layer, acc, f))
+    return out
+
+
+def maxpool1d(layer, x):
+    ch = layer["in_ch"]
+    k = layer["kernel"]
+    out = []
+    for t in range(layer["out_len"]):
+        for c in range(ch):
+            out.append(max(x[(t * k + j) * ch + c] for j in range(k)))
+    return out
+
+
+def run(layers, x):
+    """Runs all layers on q7 input list, returns q7 output list."""
+    for layer in layers:
+        if layer["type"] == DENSE:
+            x = dense(layer, x)
+        elif layer["type"] == CONV1D:
+            x = conv1d(layer, x)
+        else:
+            x = maxpool1d(layer, x)
+    return x
@@ -0,0 +1,42 @@
+/*
+ * Host bit-exactness test of nn.c.
+ *
+ * Model and test vectors are generated by nn_convert.py, expected outputs come from
+ * integer reference nn_ref.py. Device runtime is built together with CMSIS
+ * arm_dot_prod_q7.c and emulated Cortex-M4 intrinsics, every output byte must match.
+ */
+
+#include <stdio.h>
+#include "nn_model.h"
+#include "nn_vectors.h"
+
+DWT_Type HOST_Dwt;
+
+static q7_t TEST_Arena[2 * 4096];
+
+int main(void) {
+	NN_t nn;
+	const q7_t* out;
+	uint32_t i, j, mismatches = 0;
+
+	if (NN_Init(&nn, &NN_TEST_MODEL, TEST_Arena, sizeof(TEST_Arena)) != NN_Result_Ok) {
+		printf("nn: model rejected by NN_Init\n");
+		return 1;
+	}
+
+	for (i = 0; i < NN_TEST_COUNT; i++) {
+		out = NN_Run(&nn, NN_TestInput[i]);
+		for (j = 0; j < NN_TEST_OUTPUT_SIZE; j++) {
+			if (out[j] != NN_TestOutput[i][j]) {
+				if (mismatches < 10) {
+					printf("nn: vector %u output %u is %d, reference %d\n", i, j, out[j], NN_TestOutput[i][j]);
+				}
+				mismatches++;
+			}
+		}
+	}
+
+	printf(mismatches ? "nn: %u of %u outputs differ from reference\n" : "nn: %u differences in %u outputs, bit-exact\n",
+		mismatches, NN_TEST_COUNT * NN_TEST_OUTPUT_SIZE);
+	return mismatches ? 1 : 0;
+}
@@ -0,0 +1,77 @@
+#ifndef _ARM_MATH_H
+#define _ARM_MATH_H
+
+/*
+ * Host replacement of CMSIS arm_math.h, so device modules and CMSIS DSP sources
+ * build on PC for tests. Types match CMSIS, Cortex-M4 SIMD intrinsics are emulated
+ * bit-exactly in plain C.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#define PI							3.14159265358979f
+
+#define __INLINE					inline
+#define __STATIC_INLINE				static inline
+
+typedef int8_t q7_t;
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+typedef int64_t q63_t;
+typedef float float32_t;
+typedef double float64_t;
+
+/* Unaligned 32-bit access, allowed on Cortex-M4 */
+#define __SIMD32_TYPE				int32_t
+#define __SIMD32(addr)				(*(__SIMD32_TYPE **) & (addr))
+#define __SIMD32_CONST(addr)		((__SIMD32_TYPE *)(addr))
+#define _SIMD32_OFFSET(addr)		(*(__SIMD32_TYPE *) (addr))
+
+__STATIC_INLINE int32_t __SSAT(int32_t x, uint32_t n) {
+	int32_t max = (int32_t)((1UL << (n - 1)) - 1);
+
+	if (x > max) {
+		return max;
+	}
+	if (x < -max - 1) {
+		return -max - 1;
+	}
+	return x;
+}
+
+__STATIC_INLINE uint32_t __USAT(int32_t x, uint32_t n) {
+	uint32_t max = (uint32_t)((1ULL << n) - 1);
+
+	if (x < 0) {
+		return 0;
+	}
+	return (uint32_t)x > max ? max : (uint32_t)x;
+}
+
+__STATIC_INLINE uint32_t __ROR(uint32_t x, uint32_t n) {
+	n &= 31;
+	return n ? (x >> n) | (x << (32 - n)) : x;
+}
+
+/* Sign extend bytes 0 and 2 to halfwords */
+__STATIC_INLINE int32_t __SXTB16(uint32_t x) {
+	uint32_t lo = (uint32_t)(uint16_t)(int16_t)(int8_t)(x & 0xFF);
+	uint32_t hi = (uint32_t)(uint16_t)(int16_t)(int8_t)((x >> 16) & 0xFF);
+
+	return (int32_t)(lo | hi << 16);
+}
+
+/* Dual signed 16-bit multiply with add, operands are taken as halfwords whatever their value */
+__STATIC_INLINE int32_t __SMUAD(int32_t x, int32_t y) {
+	return (int32_t)((uint32_t)((int16_t)x * (int16_t)y) + (uint32_t)((int16_t)(x >> 16) * (int16_t)(y >> 16)));
+}
+
+__STATIC_INLINE int32_t __SMLAD(int32_t x, int32_t y, int32_t acc) {
+	return (int32_t)((uint32_t)__SMUAD(x, y) + (uint32_t)acc);
+}
+
+void arm_dot_prod_q7(q7_t* pSrcA, q7_t* pSrcB, uint32_t blockSize, q31_t* result);
+
+#endif
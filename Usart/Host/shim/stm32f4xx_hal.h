@@ -0,0 +1,22 @@
+#ifndef __STM32F4xx_HAL_H
+#define __STM32F4xx_HAL_H
+
+/*
+ * Host replacement of HAL header for tests. Only what signal processing modules
+ * use is provided, DWT cycle counter is plain variable which stays at zero.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define __IO						volatile
+#define __weak						__attribute__((weak))
+
+typedef struct {
+	__IO uint32_t CYCCNT;
+} DWT_Type;
+
+extern DWT_Type HOST_Dwt;
+#define DWT							(&HOST_Dwt)
+
+#endif
@@ -0,0 +1,290 @@
+#include "dtw.h"
+
+/* Cost of cells outside band */
+#define DTW_INF						0xFFFFFFFFUL
+
+static void DTW_Prepare(const LIS3DSH_Axes_t* samples, uint16_t count, DTW_Query_t* q);
+static uint32_t DTW_LowerBound(const DTW_Query_t* q, const DTW_Template_t* t);
+static uint32_t DTW_Distance(const DTW_Point_t* a, const DTW_Point_t* b, uint32_t best, uint32_t (*rows)[DTW_LENGTH]);
+
+/* Squared distance of two packed points */
+static __INLINE uint32_t DTW_PointDistance(const DTW_Point_t* a, const DTW_Point_t* b) {
+	int32_t dxy = __SSUB16(a->XY, b->XY);
+	int32_t dz = __SSUB16(a->Z, b->Z);
+
+	return (uint32_t)__SMLAD(dz, dz, __SMUAD(dxy, dxy));
+}
+
+void DTW_Init(DTW_t* d) {
+	memset(d, 0, sizeof(DTW_t));
+}
+
+DTW_Result_t DTW_AddTemplate(DTW_t* d, int16_t id, const LIS3DSH_Axes_t* samples, uint16_t count) {
+	DTW_Template_t* t;
+	DTW_Query_t* q = &d->Query;
+	int16_t v, hi, lo;
+	int16_t i, j, a;
+
+	if (d->Count >= DTW_MAX_TEMPLATES || count < DTW_MIN_SAMPLES || count > DTW_MAX_SAMPLES) {
+		return DTW_Result_Error;
+	}
+	t = &d->Templates[d->Count];
+
+	DTW_Prepare(samples, count, q);
+	t->Id = id;
+	memcpy(t->Points, q->Points, sizeof(t->Points));
+
+	/* Envelope of template over band, for LB_Keogh */
+	for (i = 0; i < DTW_LENGTH; i++) {
+		for (a = 0; a < 3; a++) {
+			hi = lo = q->Values[i][a];
+			for (j = i - DTW_BAND; j <= i + DTW_BAND; j++) {
+				if (j < 0 || j >= DTW_LENGTH) {
+					continue;
+				}
+				v = q->Values[j][a];
+				if (v > hi) {
+					hi = v;
+				}
+				if (v < lo) {
+					lo = v;
+				}
+			}
+			t->Upper[i][a] = hi;
+			t->Lower[i][a] = lo;
+		}
+	}
+	d->Count++;
+
+	return DTW_Result_Ok;
+}
+
+int16_t DTW_Process(DTW_t* d, const LIS3DSH_Axes_t* acc, uint16_t count) {
+	int16_t result = DTW_NONE, id;
+	int32_t energy, e, v[3];
+	uint16_t a;
+
+	while (count--) {
+		v[0] = acc->X;
+		v[1] = acc->Y;
+		v[2] = acc->Z;
+
+		if (!d->Primed) {
+			for (a = 0; a < 3; a++) {
+				d->Gravity[a] = v[a] << 6;
+			}
+			d->Primed = 1;
+		}
+
+		/* Deviation from gravity */
+		energy = 0;
+		for (a = 0; a < 3; a++) {
+			e = v[a] - (d->Gravity[a] >> 6);
+			energy += e < 0 ? -e : e;
+		}
+
+		if (!d->Active) {
+			/* Track gravity only between gestures */
+			for (a = 0; a < 3; a++) {
+				d->Gravity[a] += v[a] - (d->Gravity[a] >> 6);
+			}
+			if (energy > DTW_START_LEVEL) {
+				d->Active = 1;
+				d->Length = 0;
+				d->Quiet = 0;
+			}
+		}
+
+		if (d->Active) {
+			d->Capture[d->Length++] = *acc;
+
+			/* Hysteresis, gesture ends below half of start level */
+			if (energy < DTW_START_LEVEL / 2) {
+				d->Quiet++;
+			} else {
+				d->Quiet = 0;
+			}
+
+			if (d->Quiet >= DTW_QUIET) {
+				d->Active = 0;
+				if (d->Length - d->Quiet >= DTW_MIN_SAMPLES) {
+					id = DTW_Match(d, d->Capture, d->Length - d->Quiet);
+					if (id != DTW_NONE) {
+						result = id;
+					}
+				}
+			} else if (d->Length >= DTW_MAX_SAMPLES) {
+				/* Too long for gesture, wait for next start */
+				d->Active = 0;
+			}
+		}
+		acc++;
+	}
+
+	return result;
+}
+
+int16_t DTW_Match(DTW_t* d, const LIS3DSH_Axes_t* samples, uint16_t count) {
+	DTW_Query_t* q = &d->Query;
+	uint32_t* bound = d->Bound;
+	uint8_t* order = d->Order;
+	uint32_t best, dist, b;
+	uint8_t i, j, o;
+	int16_t id = DTW_NONE;
+
+	if (d->Count == 0 || count < DTW_MIN_SAMPLES || count > DTW_MAX_SAMPLES) {
+		return DTW_NONE;
+	}
+	DTW_Prepare(samples, count, q);
+
+	/* Templates sorted by lower bound, most promising first */
+	for (i = 0; i < d->Count; i++) {
+		b = DTW_LowerBound(q, &d->Templates[i]);
+		for (j = i; j > 0 && bound[j - 1] > b; j--) {
+			bound[j] = bound[j - 1];
+			order[j] = order[j - 1];
+		}
+		bound[j] = b;
+		order[j] = i;
+	}
+
+	/* Only matches within threshold are of interest */
+	best = DTW_MATCH_MAX * DTW_LENGTH;
+	for (i = 0; i < d->Count; i++) {
+		if (bound[i] >= best) {
+			break;
+		}
+		o = order[i];
+		dist = DTW_Distance(q->Points, d->Templates[o].Points, best, d->Rows);
+		if (dist < best) {
+			best = dist;
+			id = d->Templates[o].Id;
+		}
+	}
+
+	if (id != DTW_NONE) {
+		d->Distance = best / DTW_LENGTH;
+	}
+
+	return id;
+}
+
+void DTW_Pack(const DTW_t* d, int16_t id, uint8_t* data) {
+	data[0] = 'G';
+	data[1] = (uint8_t)id;
+	data[2] = (uint8_t)d->Distance;
+	data[3] = (uint8_t)(d->Distance >> 8);
+	data[4] = (uint8_t)(d->Distance >> 16);
+	data[5] = (uint8_t)(d->Distance >> 24);
+	data[6] = d->Count;
+	data[7] = 0;
+	data[8] = 0;
+	data[9] = 0;
+}
+
+static void DTW_Prepare(const LIS3DSH_Axes_t* samples, uint16_t count, DTW_Query_t* q) {
+	int32_t sum[3] = {0, 0, 0}, v[3], x0, x1;
+	uint32_t pos, step = ((uint32_t)(count - 1) << 16) / (DTW_LENGTH - 1);
+	uint16_t i, idx, a;
+	int32_t frac;
+
+	/* Linear resampling to fixed length, 15 bits fraction keeps full scale difference times fraction in 32 bits */
+	for (i = 0, pos = 0; i < DTW_LENGTH; i++, pos += step) {
+		idx = pos >> 16;
+		frac = (pos & 0xFFFF) >> 1;
+		if (idx >= count - 1) {
+			idx = count - 2;
+			frac = 0x8000;
+		}
+		for (a = 0; a < 3; a++) {
+			x0 = ((const int16_t *)&samples[idx])[a];
+			x1 = ((const int16_t *)&samples[idx + 1])[a];
+			v[a] = x0 + (((x1 - x0) * frac) >> 15);
+			q->Values[i][a] = (int16_t)v[a];
+			sum[a] += v[a];
+		}
+	}
+
+	/* Remove orientation, scale for 32-bit path sums */
+	for (a = 0; a < 3; a++) {
+		sum[a] /= DTW_LENGTH;
+	}
+	for (i = 0; i < DTW_LENGTH; i++) {
+		for (a = 0; a < 3; a++) {
+			q->Values[i][a] = (int16_t)((q->Values[i][a] - sum[a]) >> DTW_SHIFT);
+		}
+		q->Points[i].XY = __PKHBT(q->Values[i][0], q->Values[i][1], 16);
+		q->Points[i].Z = (uint16_t)q->Values[i][2];
+	}
+}
+
+static uint32_t DTW_LowerBound(const DTW_Query_t* q, const DTW_Template_t* t) {
+	uint32_t lb = 0;
+	int32_t e;
+	uint16_t i, a;
+
+	for (i = 0; i < DTW_LENGTH; i++) {
+		for (a = 0; a < 3; a++) {
+			if (q->Values[i][a] > t->Upper[i][a]) {
+				e = q->Values[i][a] - t->Upper[i][a];
+			} else if (q->Values[i][a] < t->Lower[i][a]) {
+				e = t->Lower[i][a] - q->Values[i][a];
+			} else {
+				continue;
+			}
+			lb += (uint32_t)(e * e);
+		}
+	}
+
+	return lb;
+}
+
+static uint32_t DTW_Distance(const DTW_Point_t* a, const DTW_Point_t* b, uint32_t best, uint32_t (*rows)[DTW_LENGTH]) {
+	uint32_t* prev = rows[0];
+	uint32_t* cur = rows[1];
+	uint32_t* tmp;
+	uint32_t m, rowMin;
+	int16_t i, j, lo, hi;
+
+	for (i = 0; i < DTW_LENGTH; i++) {
+		/* Cells outside band stay infinite */
+		lo = i - DTW_BAND < 0 ? 0 : i - DTW_BAND;
+		hi = i + DTW_BAND >= DTW_LENGTH ? DTW_LENGTH - 1 : i + DTW_BAND;
+		rowMin = DTW_INF;
+
+		for (j = lo; j <= hi; j++) {
+			if (i == 0 && j == 0) {
+				m = 0;
+			} else {
+				m = DTW_INF;
+				if (i > 0 && j <= i - 1 + DTW_BAND) {
+					m = prev[j];
+					if (j > 0 && prev[j - 1] < m) {
+						m = prev[j - 1];
+					}
+				}
+				if (j > lo && cur[j - 1] < m) {
+					m = cur[j - 1];
+				}
+				if (m == DTW_INF) {
+					cur[j] = DTW_INF;
+					continue;
+				}
+			}
+			cur[j] = m + DTW_PointDistance(&a[i], &b[j]);
+			if (cur[j] < rowMin) {
+				rowMin = cur[j];
+			}
+		}
+
+		/* Early abandon, every path crosses this row */
+		if (rowMin >= best) {
+			return DTW_INF;
+		}
+		tmp = prev;
+		prev = cur;
+		cur = tmp;
+	}
+
+	return prev[DTW_LENGTH - 1];
+}
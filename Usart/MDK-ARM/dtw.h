@@ -0,0 +1,144 @@
+#ifndef DTW_H
+#define DTW_H 100
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Wrist gesture recognition with dynamic time warping against stored templates.
+ *
+ * Accelerometer stream is segmented by motion energy: gesture starts when deviation
+ * from slowly tracked gravity exceeds DTW_START_LEVEL and ends after DTW_QUIET quiet
+ * samples. Captured gesture is linearly resampled to DTW_LENGTH points, mean of each
+ * axis is removed and values are shifted by DTW_SHIFT, so squared distances of
+ * three axes along any warping path fit 32 bits.
+ *
+ * Each point is packed as two words {X, Y} and {Z, 0}, so point distance is
+ * two __SSUB16() and __SMUAD() / __SMLAD().
+ *
+ * Templates are ordered by LB_Keogh lower bound over their band envelope, template
+ * is skipped when its bound exceeds best distance so far, and DTW row is abandoned
+ * when its minimum exceeds it. DTW is limited to Sakoe-Chiba band of DTW_BAND, so
+ * worst case after gesture end is DTW_MAX_TEMPLATES * DTW_LENGTH * (2 * DTW_BAND + 1) cells.
+ *
+ * Levels are in raw accelerometer units at +-2 g scale, 1 g is about 16384.
+ */
+
+#include "stm32f4xx_hal.h"
+#include "arm_math.h"
+#include "lis3dsh.h"
+
+/* Points per gesture after resampling */
+#define DTW_LENGTH					32
+/* Sakoe-Chiba band half width in points */
+#define DTW_BAND					4
+/* Maximal number of stored templates */
+#define DTW_MAX_TEMPLATES			8
+
+/* Segmentation, at 100 Hz accelerometer rate */
+#define DTW_START_LEVEL				5000
+#define DTW_QUIET					15
+#define DTW_MIN_SAMPLES				20
+#define DTW_MAX_SAMPLES				200
+
+/* Right shift of raw values, keeps distances in 32 bits */
+#define DTW_SHIFT					5
+
+/* Maximal mean distance per point of accepted match, about 0.3 g */
+#define DTW_MATCH_MAX				(150UL * 150UL)
+
+/* Returned when no gesture was recognized */
+#define DTW_NONE					(-1)
+
+typedef enum {
+	DTW_Result_Ok = 0x00,     /*!< Everything OK */
+	DTW_Result_Error          /*!< No space or invalid gesture */
+} DTW_Result_t;
+
+typedef struct {
+	int32_t XY;               /*!< X in lower and Y in upper halfword */
+	int32_t Z;                /*!< Z in lower halfword */
+} DTW_Point_t;
+
+typedef struct {
+	int16_t Id;               /*!< User identifier of gesture */
+	DTW_Point_t Points[DTW_LENGTH];
+	int16_t Upper[DTW_LENGTH][3]; /*!< LB_Keogh upper envelope over band */
+	int16_t Lower[DTW_LENGTH][3]; /*!< LB_Keogh lower envelope over band */
+} DTW_Template_t;
+
+typedef struct {
+	DTW_Point_t Points[DTW_LENGTH];
+	int16_t Values[DTW_LENGTH][3]; /*!< Resampled values before packing */
+} DTW_Query_t;
+
+typedef struct {
+	DTW_Template_t Templates[DTW_MAX_TEMPLATES];
+	uint8_t Count;            /*!< Number of stored templates */
+	int32_t Gravity[3];       /*!< Gravity estimate, 6 fractional bits */
+	uint8_t Primed;           /*!< Set to 1 when gravity was initialized */
+	LIS3DSH_Axes_t Capture[DTW_MAX_SAMPLES];
+	uint16_t Length;          /*!< Samples in capture */
+	uint8_t Active;           /*!< Set to 1 during gesture */
+	uint8_t Quiet;            /*!< Quiet samples in a row */
+	uint32_t Distance;        /*!< Mean distance per point of last match */
+	/* Scratch of matching, kept off the 1 KB main stack shared with nested interrupts */
+	DTW_Query_t Query;        /*!< Prepared gesture */
+	uint32_t Bound[DTW_MAX_TEMPLATES]; /*!< Sorted lower bounds of templates */
+	uint8_t Order[DTW_MAX_TEMPLATES]; /*!< Templates in order of lower bound */
+	uint32_t Rows[2][DTW_LENGTH]; /*!< Previous and current DTW row */
+} DTW_t;
+
+/**
+ * @brief  Initializes recognizer without templates
+ * @param  *d: Pointer to @ref DTW_t structure
+ * @retval None
+ */
+void DTW_Init(DTW_t* d);
+
+/**
+ * @brief  Stores recorded gesture as template
+ * @param  *d: Pointer to @ref DTW_t structure
+ * @param  id: User identifier of gesture, returned when recognized
+ * @param  *samples: Pointer to raw accelerometer samples of gesture
+ * @param  count: Number of samples, from DTW_MIN_SAMPLES to DTW_MAX_SAMPLES
+ * @retval Member of @ref DTW_Result_t enumeration
+ */
+DTW_Result_t DTW_AddTemplate(DTW_t* d, int16_t id, const LIS3DSH_Axes_t* samples, uint16_t count);
+
+/**
+ * @brief  Processes accelerometer samples
+ * @param  *d: Pointer to @ref DTW_t structure
+ * @param  *acc: Pointer to raw accelerometer samples
+ * @param  count: Number of samples
+ * @retval Id of recognized gesture or @ref DTW_NONE
+ */
+int16_t DTW_Process(DTW_t* d, const LIS3DSH_Axes_t* acc, uint16_t count);
+
+/**
+ * @brief  Finds closest template to gesture
+ * @param  *d: Pointer to @ref DTW_t structure
+ * @param  *samples: Pointer to raw accelerometer samples of gesture
+ * @param  count: Number of samples, from DTW_MIN_SAMPLES to DTW_MAX_SAMPLES
+ * @retval Id of closest template within DTW_MATCH_MAX or @ref DTW_NONE
+ */
+int16_t DTW_Match(DTW_t* d, const LIS3DSH_Axes_t* samples, uint16_t count);
+
+/**
+ * @brief  Packs recognized gesture to 10 bytes for transmission
+ * @note   Layout: 'G', id, mean distance (LE, 32 bits), number of templates, 3 bytes zero
+ * @param  *d: Pointer to @ref DTW_t structure
+ * @param  id: Recognized gesture
+ * @param  *data: Pointer to 10 bytes output buffer
+ * @retval None
+ */
+void DTW_Pack(const DTW_t* d, int16_t id, uint8_t* data);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
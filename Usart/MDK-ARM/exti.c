@@ -1,5 +1,7 @@
 #include "exti.h"
 
+static EXTI_Result_t EXTI_GetIRQ(uint16_t GPIO_Line, IRQn_Type* irq);
+
 EXTI_Result_t EXTI_Attach(GPIO_TypeDef* GPIOx, uint16_t GPIO_Line, EXTI_Trigger_t trigger) {
 	GPIO_PuPd_t PuPd;
 	uint8_t pinsource, portsource;
@@ -32,71 +34,10 @@ EXTI_Result_t EXTI_Attach(GPIO_TypeDef* GPIOx, uint16_t GPIO_Line, EXTI_Trigger_
 		return EXTI_Result_Error;
 	}
 	
-#if defined(STM32F0xx)
 	/* Get IRQ channel */
-	switch (GPIO_Line) {
-		case GPIO_PIN_0:
-		case GPIO_PIN_1:
-			irqchannel = EXTI0_1_IRQn;
-			break;
-		case GPIO_PIN_2:
-		case GPIO_PIN_3:
-			irqchannel = EXTI2_3_IRQn;
-			break;
-		case GPIO_Pin_4:
-		case GPIO_PIN_5:
-		case GPIO_PIN_6:
-		case GPIO_PIN_7:
-		case GPIO_PIN_8:
-		case GPIO_PIN_9:
-		case GPIO_PIN_10:
-		case GPIO_PIN_11:
-		case GPIO_PIN_12:
-		case GPIO_PIN_13:
-		case GPIO_PIN_14:
-		case GPIO_PIN_15:
-			irqchannel = EXTI4_15_IRQn;
-			break;
-		default:
-			return EXTI_Result_Error;
-	}
-#else
-	/* Get IRQ channel */
-	switch (GPIO_Line) {
-		case GPIO_PIN_0:
-			irqchannel = EXTI0_IRQn;
-			break;
-		case GPIO_PIN_1:
-			irqchannel = EXTI1_IRQn;
-			break;
-		case GPIO_PIN_2:
-			irqchannel = EXTI2_IRQn;
-			break;
-		case GPIO_PIN_3:
-			irqchannel = EXTI3_IRQn;
-			break;
-		case GPIO_PIN_4:
-			irqchannel = EXTI4_IRQn;
-			break;
-		case GPIO_PIN_5:
-		case GPIO_PIN_6:
-		case GPIO_PIN_7:
-		case GPIO_PIN_8:
-		case GPIO_PIN_9:
-			irqchannel = EXTI9_5_IRQn;
-			break;
-		case GPIO_PIN_10:
-		case GPIO_PIN_11:
-		case GPIO_PIN_12:
-		case GPIO_PIN_13:
-		case GPIO_PIN_14:
-		case GPIO_PIN_15:
-			irqchannel = EXTI15_10_IRQn;
-			break;
-		default:
-			return EXTI_Result_Error;
+	if (EXTI_GetIRQ(GPIO_Line, &irqchannel) != EXTI_Result_Ok) {
+		return EXTI_Result_Error;
 	}
-#endif
 
 	/* Check pull settings */
 	if (trigger == EXTI_Trigger_Falling) {
@@ -156,6 +97,21 @@ EXTI_Result_t EXTI_Attach(GPIO_TypeDef* GPIOx, uint16_t GPIO_Line, EXTI_Trigger_
 	return EXTI_Result_Ok;
 }
 
+EXTI_Result_t EXTI_SetPriority(uint16_t GPIO_Line, uint32_t preemptPriority, uint32_t subPriority) {
+	IRQn_Type irqchannel;
+	
+	/* Get IRQ channel */
+	if (EXTI_GetIRQ(GPIO_Line, &irqchannel) != EXTI_Result_Ok) {
+		return EXTI_Result_Error;
+	}
+	
+	/* Lines 5 to 15 share channels, priority applies to all of them */
+	HAL_NVIC_SetPriority(irqchannel, preemptPriority, subPriority);
+	
+	/* Return OK */
+	return EXTI_Result_Ok;
+}
+
 EXTI_Result_t EXTI_Detach(uint16_t GPIO_Line) {
 	/* Disable EXTI for specific GPIO line */
 	EXTI->IMR &= ~GPIO_Line;
@@ -178,6 +134,74 @@ void EXTI_DeInit(void) {
 	EXTI->PR &= 0xFFFF0000;
 }
 
+static EXTI_Result_t EXTI_GetIRQ(uint16_t GPIO_Line, IRQn_Type* irq) {
+#if defined(STM32F0xx)
+	switch (GPIO_Line) {
+		case GPIO_PIN_0:
+		case GPIO_PIN_1:
+			*irq = EXTI0_1_IRQn;
+			break;
+		case GPIO_PIN_2:
+		case GPIO_PIN_3:
+			*irq = EXTI2_3_IRQn;
+			break;
+		case GPIO_Pin_4:
+		case GPIO_PIN_5:
+		case GPIO_PIN_6:
+		case GPIO_PIN_7:
+		case GPIO_PIN_8:
+		case GPIO_PIN_9:
+		case GPIO_PIN_10:
+		case GPIO_PIN_11:
+		case GPIO_PIN_12:
+		case GPIO_PIN_13:
+		case GPIO_PIN_14:
+		case GPIO_PIN_15:
+			*irq = EXTI4_15_IRQn;
+			break;
+		default:
+			return EXTI_Result_Error;
+	}
+#else
+	switch (GPIO_Line) {
+		case GPIO_PIN_0:
+			*irq = EXTI0_IRQn;
+			break;
+		case GPIO_PIN_1:
+			*irq = EXTI1_IRQn;
+			break;
+		case GPIO_PIN_2:
+			*irq = EXTI2_IRQn;
+			break;
+		case GPIO_PIN_3:
+			*irq = EXTI3_IRQn;
+			break;
+		case GPIO_PIN_4:
+			*irq = EXTI4_IRQn;
+			break;
+		case GPIO_PIN_5:
+		case GPIO_PIN_6:
+		case GPIO_PIN_7:
+		case GPIO_PIN_8:
+		case GPIO_PIN_9:
+			*irq = EXTI9_5_IRQn;
+			break;
+		case GPIO_PIN_10:
+		case GPIO_PIN_11:
+		case GPIO_PIN_12:
+		case GPIO_PIN_13:
+		case GPIO_PIN_14:
+		case GPIO_PIN_15:
+			*irq = EXTI15_10_IRQn;
+			break;
+		default:
+			return EXTI_Result_Error;
+	}
+#endif
+
+	return EXTI_Result_Ok;
+}
+
 __weak void EXTI_Handler(uint16_t GPIO_Pin) {
   /* NOTE : This function Should not be modified, when the callback is needed,
             the EXTI_Handler could be implemented in the user file
@@ -62,6 +62,17 @@ typedef enum {
  */
 EXTI_Result_t EXTI_Attach(GPIO_TypeDef* GPIOx, uint16_t GPIO_Line, EXTI_Trigger_t trigger);
 
+/**
+ * @brief  Sets NVIC priority of interrupt channel of GPIO line, default is EXTI_NVIC_PRIORITY
+ * @note   Use after @ref EXTI_Attach(). Lines 5 to 9 and 10 to 15 share one channel, so priority
+ *         applies to whole group.
+ * @param  GPIO_Line: Single GPIO line, GPIO_PIN_0 to GPIO_PIN_15
+ * @param  preemptPriority: Preemption priority, as in HAL_NVIC_SetPriority()
+ * @param  subPriority: Sub priority, as in HAL_NVIC_SetPriority()
+ * @retval Member of @ref EXTI_Result_t enumeration
+ */
+EXTI_Result_t EXTI_SetPriority(uint16_t GPIO_Line, uint32_t preemptPriority, uint32_t subPriority);
+
 /**
  * @brief  Detach GPIO pin from interrupt lines
  * @param  GPIO_Line: GPIO line you want to disable. Valid GPIO is GPIO_Pin_0 to GPIO_Pin_15. 
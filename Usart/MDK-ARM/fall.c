@@ -0,0 +1,99 @@
+#include "fall.h"
+#include <math.h>
+
+void FALL_Init(FALL_t* f, float32_t fs, float32_t sensitivity) {
+	float32_t level;
+
+	memset(f, 0, sizeof(FALL_t));
+	f->Fs = fs;
+	f->Sensitivity = sensitivity;
+
+	level = FALL_FREEFALL_G / sensitivity;
+	f->FreeFallSq = (uint32_t)(level * level);
+	level = FALL_IMPACT_G / sensitivity;
+	f->ImpactSq = (uint32_t)(level * level);
+
+	f->FreeFallSamples = (uint16_t)(fs * FALL_FREEFALL_MS / 1000);
+	f->ImpactSamples = (uint16_t)(fs * FALL_IMPACT_WINDOW_MS / 1000);
+	f->HoldSamples = (uint16_t)(fs * FALL_HOLD_MS / 1000);
+}
+
+uint8_t FALL_Process(FALL_t* f, const LIS3DSH_Axes_t* acc, uint8_t count) {
+	uint8_t detected = 0;
+	uint32_t m2;
+	int32_t xy;
+
+	while (count--) {
+		/* Squared magnitude, fits 32 bits unsigned at any scale */
+		xy = *__SIMD32_CONST(&acc->X);
+		m2 = (uint32_t)__SMUAD(xy, xy) + (uint32_t)((int32_t)acc->Z * acc->Z);
+		acc++;
+		f->Timer++;
+
+		switch (f->State) {
+			case FALL_State_Idle:
+				if (m2 < f->FreeFallSq) {
+					f->State = FALL_State_FreeFall;
+					f->Timer = 1;
+				}
+				break;
+			case FALL_State_FreeFall:
+				if (m2 >= f->FreeFallSq) {
+					f->State = FALL_State_Idle;
+				} else if (f->Timer >= f->FreeFallSamples) {
+					f->State = FALL_State_Falling;
+					f->FreeFallLength = f->Timer;
+				}
+				break;
+			case FALL_State_Falling:
+				if (m2 < f->FreeFallSq) {
+					/* Still falling, duration includes confirmation */
+					f->FreeFallLength = f->Timer;
+				} else if (m2 > f->ImpactSq) {
+					f->PeakSq = m2;
+					f->Falls++;
+					f->Alert = 1;
+					detected = 1;
+					f->State = FALL_State_Hold;
+					f->Timer = 0;
+				} else if (f->Timer - f->FreeFallLength >= f->ImpactSamples) {
+					f->State = FALL_State_Idle;
+				}
+				break;
+			default:
+				if (m2 > f->PeakSq) {
+					f->PeakSq = m2;
+				}
+				if (f->Timer >= f->HoldSamples) {
+					f->State = FALL_State_Idle;
+				}
+				break;
+		}
+	}
+
+	return detected;
+}
+
+uint8_t FALL_GetAlert(FALL_t* f) {
+	if (!f->Alert) {
+		return 0;
+	}
+	f->Alert = 0;
+	return 1;
+}
+
+void FALL_Pack(const FALL_t* f, uint8_t* data) {
+	uint16_t peak = (uint16_t)__USAT((int32_t)(sqrtf((float32_t)f->PeakSq) * f->Sensitivity * 100.0f), 16);
+	uint16_t ms = (uint16_t)(f->FreeFallLength * 1000.0f / f->Fs);
+
+	data[0] = 'F';
+	data[1] = (uint8_t)f->Falls;
+	data[2] = (uint8_t)(f->Falls >> 8);
+	data[3] = (uint8_t)peak;
+	data[4] = (uint8_t)(peak >> 8);
+	data[5] = (uint8_t)ms;
+	data[6] = (uint8_t)(ms >> 8);
+	data[7] = 0;
+	data[8] = 0;
+	data[9] = 0;
+}
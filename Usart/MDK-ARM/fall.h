@@ -0,0 +1,102 @@
+#ifndef FALL_H
+#define FALL_H 100
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fall detection from accelerometer samples, intended to run in data ready interrupt
+ * at highest priority, so alert is raised one sample period after impact at most.
+ *
+ * State machine on magnitude of acceleration:
+ *
+ *   Idle ---(|a| < FALL_FREEFALL_G)---> FreeFall
+ *   FreeFall ---(|a| >= FALL_FREEFALL_G before FALL_FREEFALL_MS)---> Idle
+ *   FreeFall ---(lasted FALL_FREEFALL_MS)---> Falling
+ *   Falling ---(|a| > FALL_IMPACT_G)---> alert, Hold
+ *   Falling ---(no impact in FALL_IMPACT_WINDOW_MS)---> Idle
+ *   Hold ---(FALL_HOLD_MS)---> Idle
+ *
+ * Thresholds are compared on squared magnitude in raw units, no float or square root.
+ */
+
+#include "stm32f4xx_hal.h"
+#include "arm_math.h"
+#include "lis3dsh.h"
+
+/* Free fall, all axes close to zero */
+#define FALL_FREEFALL_G				0.4f
+#define FALL_FREEFALL_MS			60
+
+/* Impact after free fall, limited by +-2 g scale */
+#define FALL_IMPACT_G				1.8f
+#define FALL_IMPACT_WINDOW_MS		800
+
+/* No new alert after detected fall */
+#define FALL_HOLD_MS				2000
+
+typedef enum {
+	FALL_State_Idle = 0x00,   /*!< Normal movement */
+	FALL_State_FreeFall,      /*!< Low acceleration, not long enough yet */
+	FALL_State_Falling,       /*!< Free fall confirmed, waiting for impact */
+	FALL_State_Hold           /*!< Fall detected, waiting before next detection */
+} FALL_State_t;
+
+typedef struct {
+	FALL_State_t State;       /*!< Current state */
+	uint16_t Timer;           /*!< Samples in current state */
+	uint32_t FreeFallSq;      /*!< Free fall threshold, squared raw units */
+	uint32_t ImpactSq;        /*!< Impact threshold, squared raw units */
+	uint16_t FreeFallSamples; /*!< Minimal free fall duration in samples */
+	uint16_t ImpactSamples;   /*!< Impact window in samples */
+	uint16_t HoldSamples;     /*!< Hold time in samples */
+	uint16_t FreeFallLength;  /*!< Free fall duration of last fall in samples */
+	uint32_t PeakSq;          /*!< Peak squared magnitude of last impact */
+	volatile uint8_t Alert;   /*!< Set to 1 on fall, cleared by @ref FALL_GetAlert() */
+	uint16_t Falls;           /*!< Number of detected falls */
+	float32_t Sensitivity;    /*!< Value of one digit in g */
+	float32_t Fs;             /*!< Sample rate in Hz */
+} FALL_t;
+
+/**
+ * @brief  Initializes fall detector
+ * @param  *f: Pointer to @ref FALL_t structure
+ * @param  fs: Accelerometer output data rate in Hz
+ * @param  sensitivity: Value of one digit in g, from @ref LIS3DSH_GetSensitivity()
+ * @retval None
+ */
+void FALL_Init(FALL_t* f, float32_t fs, float32_t sensitivity);
+
+/**
+ * @brief  Processes new samples, call from @ref LIS3DSH_SamplesCallback()
+ * @param  *f: Pointer to @ref FALL_t structure
+ * @param  *acc: Pointer to raw samples, oldest first
+ * @param  count: Number of samples
+ * @retval 1 if fall was detected, 0 otherwise
+ */
+uint8_t FALL_Process(FALL_t* f, const LIS3DSH_Axes_t* acc, uint8_t count);
+
+/**
+ * @brief  Checks and clears pending alert
+ * @param  *f: Pointer to @ref FALL_t structure
+ * @retval 1 if alert was pending, 0 otherwise
+ */
+uint8_t FALL_GetAlert(FALL_t* f);
+
+/**
+ * @brief  Packs alert to 10 bytes for transmission
+ * @note   Layout: 'F', number of falls (LE), impact peak in 0.01 g (LE), free fall ms (LE), 3 bytes zero
+ * @param  *f: Pointer to @ref FALL_t structure
+ * @param  *data: Pointer to 10 bytes output buffer
+ * @retval None
+ */
+void FALL_Pack(const FALL_t* f, uint8_t* data);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,74 @@
+#include "farrow.h"
+
+/* Pack two q13 coefficients, first one in lower half */
+#define FARROW_PAIR(lo, hi)			((int32_t)(((uint32_t)(uint16_t)(int16_t)(lo)) | ((uint32_t)(uint16_t)(int16_t)(hi) << 16)))
+
+/* Lagrange coefficients in q13 for x[n - 1], x[n] and x[n + 1], x[n + 2], q13 leaves headroom for Horner sums */
+#define FARROW_C1_A					FARROW_PAIR(-2731, -4096)   /* -1/3, -1/2 */
+#define FARROW_C1_B					FARROW_PAIR(8192, -1365)    /*    1, -1/6 */
+#define FARROW_C2_A					FARROW_PAIR(4096, -8192)    /*  1/2,   -1 */
+#define FARROW_C2_B					FARROW_PAIR(4096, 0)        /*  1/2,    0 */
+#define FARROW_C3_A					FARROW_PAIR(-1365, 4096)    /* -1/6,  1/2 */
+#define FARROW_C3_B					FARROW_PAIR(-4096, 1365)    /* -1/2,  1/6 */
+
+/* 32.32 fixed point */
+#define FARROW_ONE					((uint64_t)1 << 32)
+
+void FARROW_Init(FARROW_t* f, q15_t* state, uint32_t blockSize) {
+	f->State = state;
+	f->Pos = 0;
+	f->Step = FARROW_ONE;
+	memset(state, 0, (FARROW_HISTORY + blockSize) * sizeof(q15_t));
+}
+
+void FARROW_SetRatio(FARROW_t* f, float32_t ratio) {
+	/* Split to avoid float precision loss below 1 ppm */
+	uint32_t whole = (uint32_t)ratio;
+	f->Step = ((uint64_t)whole << 32) + (uint64_t)((ratio - whole) * 4294967296.0f);
+}
+
+void FARROW_SetDriftPpm(FARROW_t* f, float32_t ppm) {
+	int64_t delta = (int64_t)(ppm * 4294.967296f);
+
+	/* Fast local clock gives more samples than nominal, consume them faster */
+	f->Step = (uint64_t)((int64_t)FARROW_ONE + delta);
+}
+
+uint32_t FARROW_Process_q15(FARROW_t* f, const q15_t* src, q15_t* dst, uint32_t count) {
+	q15_t* buf = f->State;
+	uint32_t out = 0, i;
+	int32_t c0, c1, c2, c3, mu, acc;
+	int32_t xa, xb;
+
+	memcpy(buf + FARROW_HISTORY, src, count * sizeof(q15_t));
+
+	/* Samples x[i] .. x[i + 3] are needed, x[i + 1] is base sample */
+	while ((i = (uint32_t)(f->Pos >> 32)) + 3 < FARROW_HISTORY + count) {
+		q15_t* x = buf + i;
+
+		xa = *__SIMD32(x)++;
+		xb = *__SIMD32(x);
+
+		/* Farrow branches, q15 * q13 = q28 */
+		c0 = (int32_t)buf[i + 1] << 13;
+		c1 = __SMLAD(xb, FARROW_C1_B, __SMUAD(xa, FARROW_C1_A));
+		c2 = __SMLAD(xb, FARROW_C2_B, __SMUAD(xa, FARROW_C2_A));
+		c3 = __SMLAD(xb, FARROW_C3_B, __SMUAD(xa, FARROW_C3_A));
+
+		/* Fraction in q31, Horner evaluation */
+		mu = (int32_t)((uint32_t)f->Pos >> 1);
+		acc = (int32_t)(((int64_t)c3 * mu) >> 31) + c2;
+		acc = (int32_t)(((int64_t)acc * mu) >> 31) + c1;
+		acc = (int32_t)(((int64_t)acc * mu) >> 31) + c0;
+
+		*dst++ = (q15_t)__SSAT(acc >> 13, 16);
+		out++;
+		f->Pos += f->Step;
+	}
+
+	/* Move last samples to history */
+	f->Pos -= (uint64_t)count << 32;
+	memmove(buf, buf + count, FARROW_HISTORY * sizeof(q15_t));
+
+	return out;
+}
@@ -0,0 +1,82 @@
+#ifndef FARROW_H
+#define FARROW_H 100
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fractional resampler with continuously adjustable ratio, used to re-time
+ * stream of one bracelet to shared nominal rate when its crystal drifts.
+ *
+ * Interpolation is cubic Lagrange in Farrow structure. For position n + mu between
+ * samples x[n] and x[n + 1]:
+ *
+ *   y = ((c3 * mu + c2) * mu + c1) * mu + c0
+ *
+ * where c0..c3 are 4-tap FIRs over x[n - 1] .. x[n + 2], evaluated as two dual 16-bit
+ * multiply-accumulates each. Read position is 32.32 fixed point, so ratio resolution
+ * is far below 1 ppm.
+ *
+ * Output is delayed by FARROW_DELAY input samples. All memory is provided by user:
+ *  - q15_t state[FARROW_HISTORY + blockSize]
+ */
+
+#include "stm32f4xx_hal.h"
+#include "arm_math.h"
+
+/* Number of input samples kept between blocks */
+#define FARROW_HISTORY				3
+
+/* Delay of output in input samples */
+#define FARROW_DELAY				2
+
+typedef struct {
+	q15_t* State;     /*!< History followed by current block */
+	uint64_t Pos;     /*!< Read position in state buffer, 32.32 fixed point */
+	uint64_t Step;    /*!< Input samples per output sample, 32.32 fixed point */
+} FARROW_t;
+
+/**
+ * @brief  Initializes resampler with ratio 1
+ * @param  *f: Pointer to @ref FARROW_t structure
+ * @param  *state: Pointer to state buffer with @ref FARROW_HISTORY + blockSize samples
+ * @param  blockSize: Maximal number of input samples per call
+ * @retval None
+ */
+void FARROW_Init(FARROW_t* f, q15_t* state, uint32_t blockSize);
+
+/**
+ * @brief  Sets conversion ratio
+ * @param  *f: Pointer to @ref FARROW_t structure
+ * @param  ratio: Input rate divided by output rate, from 0.5 to 2
+ * @retval None
+ */
+void FARROW_SetRatio(FARROW_t* f, float32_t ratio);
+
+/**
+ * @brief  Sets ratio from measured clock drift
+ * @param  *f: Pointer to @ref FARROW_t structure
+ * @param  ppm: Deviation of local sample rate from nominal in parts per million,
+ *         positive when local crystal is fast
+ * @retval None
+ */
+void FARROW_SetDriftPpm(FARROW_t* f, float32_t ppm);
+
+/**
+ * @brief  Resamples block of samples
+ * @param  *f: Pointer to @ref FARROW_t structure
+ * @param  *src: Pointer to input samples
+ * @param  *dst: Pointer to output samples, at least count / ratio + 1
+ * @param  count: Number of input samples, up to blockSize
+ * @retval Number of output samples
+ */
+uint32_t FARROW_Process_q15(FARROW_t* f, const q15_t* src, q15_t* dst, uint32_t count);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
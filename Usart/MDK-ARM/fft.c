@@ -0,0 +1,117 @@
+#include "fft.h"
+
+typedef struct {
+	uint16_t Len;
+	const arm_cfft_instance_f32* Cfft;
+	const float32_t* TwiddleRfft;
+} FFT_Rfft_t;
+
+/* Real FFT of length N uses complex FFT of length N/2 */
+static const FFT_Rfft_t FFT_Rfft[] = {
+#ifdef FFT_RFFT_F32_32
+	{32, &arm_cfft_sR_f32_len16, twiddleCoef_rfft_32},
+#endif
+#ifdef FFT_RFFT_F32_64
+	{64, &arm_cfft_sR_f32_len32, twiddleCoef_rfft_64},
+#endif
+#ifdef FFT_RFFT_F32_128
+	{128, &arm_cfft_sR_f32_len64, twiddleCoef_rfft_128},
+#endif
+#ifdef FFT_RFFT_F32_256
+	{256, &arm_cfft_sR_f32_len128, twiddleCoef_rfft_256},
+#endif
+#ifdef FFT_RFFT_F32_512
+	{512, &arm_cfft_sR_f32_len256, twiddleCoef_rfft_512},
+#endif
+#ifdef FFT_RFFT_F32_1024
+	{1024, &arm_cfft_sR_f32_len512, twiddleCoef_rfft_1024},
+#endif
+#ifdef FFT_RFFT_F32_2048
+	{2048, &arm_cfft_sR_f32_len1024, twiddleCoef_rfft_2048},
+#endif
+#ifdef FFT_RFFT_F32_4096
+	{4096, &arm_cfft_sR_f32_len2048, twiddleCoef_rfft_4096},
+#endif
+	{0, NULL, NULL}
+};
+
+static const arm_cfft_instance_f32* const FFT_Cfft[] = {
+#ifdef FFT_CFFT_F32_16
+	&arm_cfft_sR_f32_len16,
+#endif
+#ifdef FFT_CFFT_F32_32
+	&arm_cfft_sR_f32_len32,
+#endif
+#ifdef FFT_CFFT_F32_64
+	&arm_cfft_sR_f32_len64,
+#endif
+#ifdef FFT_CFFT_F32_128
+	&arm_cfft_sR_f32_len128,
+#endif
+#ifdef FFT_CFFT_F32_256
+	&arm_cfft_sR_f32_len256,
+#endif
+#ifdef FFT_CFFT_F32_512
+	&arm_cfft_sR_f32_len512,
+#endif
+#ifdef FFT_CFFT_F32_1024
+	&arm_cfft_sR_f32_len1024,
+#endif
+#ifdef FFT_CFFT_F32_2048
+	&arm_cfft_sR_f32_len2048,
+#endif
+#ifdef FFT_CFFT_F32_4096
+	&arm_cfft_sR_f32_len4096,
+#endif
+	NULL
+};
+
+arm_status FFT_RfftInit_f32(arm_rfft_fast_instance_f32* S, uint16_t fftLen) {
+	const FFT_Rfft_t* r;
+
+	for (r = FFT_Rfft; r->Len; r++) {
+		if (r->Len == fftLen) {
+			S->Sint = *r->Cfft;
+			S->fftLenRFFT = fftLen;
+			S->pTwiddleRFFT = (float32_t *)r->TwiddleRfft;
+			return ARM_MATH_SUCCESS;
+		}
+	}
+
+	return ARM_MATH_ARGUMENT_ERROR;
+}
+
+const arm_cfft_instance_f32* FFT_GetCfft_f32(uint16_t fftLen) {
+	const arm_cfft_instance_f32* const* c;
+
+	for (c = FFT_Cfft; *c; c++) {
+		if ((*c)->fftLen == fftLen) {
+			return *c;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Bit reversal for arm_cfft_f32(), assembly version (arm_bitreversal2.S)
+ * is not part of DSP_Lib sources in this project
+ */
+void arm_bitreversal_32(uint32_t* pSrc, const uint16_t bitRevLen, const uint16_t* pBitRevTable) {
+	uint32_t a, b, i, tmp;
+
+	for (i = 0; i < bitRevLen; i += 2) {
+		a = pBitRevTable[i] >> 2;
+		b = pBitRevTable[i + 1] >> 2;
+
+		/* Real part */
+		tmp = pSrc[a];
+		pSrc[a] = pSrc[b];
+		pSrc[b] = tmp;
+
+		/* Imaginary part */
+		tmp = pSrc[a + 1];
+		pSrc[a + 1] = pSrc[b + 1];
+		pSrc[b + 1] = tmp;
+	}
+}
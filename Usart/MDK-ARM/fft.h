@@ -0,0 +1,54 @@
+#ifndef FFT_H
+#define FFT_H 100
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Build-time selection of FFT lengths.
+ *
+ * arm_rfft_fast_init_f32() and similar init functions reference tables of all lengths,
+ * so all twiddle and bit-reversal tables end up in flash (more than 100 kB).
+ * Functions here reference only lengths enabled below, every table and every
+ * arm_cfft_sR_f32_lenN structure is in own ELF section ("One ELF Section per Function"),
+ * so linker removes everything else.
+ *
+ * Enable lengths with project defines, for example FFT_CONFIG_CUSTOM,FFT_RFFT_F32_256.
+ * Without FFT_CONFIG_CUSTOM default pipeline configuration below is used.
+ *
+ * Image size is printed after each build and per object sizes are in map file,
+ * sections removed by linker are listed there as well.
+ */
+
+#include "stm32f4xx_hal.h"
+#include "arm_math.h"
+#include "arm_const_structs.h"
+
+/* Default pipeline configuration */
+#ifndef FFT_CONFIG_CUSTOM
+#define FFT_RFFT_F32_256                /* Heart rate variability, respiration rate */
+#endif
+
+/**
+ * @brief  Initializes real FFT instance, replacement for arm_rfft_fast_init_f32()
+ * @param  *S: Pointer to arm_rfft_fast_instance_f32 structure
+ * @param  fftLen: Real FFT length, must be enabled with FFT_RFFT_F32_<fftLen> define
+ * @retval ARM_MATH_SUCCESS or ARM_MATH_ARGUMENT_ERROR if length is not enabled
+ */
+arm_status FFT_RfftInit_f32(arm_rfft_fast_instance_f32* S, uint16_t fftLen);
+
+/**
+ * @brief  Gets complex FFT instance for use with arm_cfft_f32()
+ * @param  fftLen: Complex FFT length, must be enabled with FFT_CFFT_F32_<fftLen> define
+ * @retval Pointer to constant instance or NULL if length is not enabled
+ */
+const arm_cfft_instance_f32* FFT_GetCfft_f32(uint16_t fftLen);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,117 @@
+#include "fusion.h"
+
+/* Averaging factor for gravity estimate, per filter step */
+#define FUSION_DC_ALPHA				0.01f
+
+/* Averaging factor for confidence statistics, per filter step */
+#define FUSION_STAT_ALPHA			0.05f
+
+/* Private functions */
+static void FUSION_Step(FUSION_t* f, float32_t y, const float32_t* a);
+
+void FUSION_Init(FUSION_t* f, float32_t dt, float32_t qSignal, float32_t qCoupling, float32_t r) {
+	uint32_t i;
+
+	memset(f, 0, sizeof(FUSION_t));
+
+	/* Constant matrices */
+	for (i = 0; i < FUSION_STATES; i++) {
+		f->F[i * FUSION_STATES + i] = 1.0f;
+		f->P[i * FUSION_STATES + i] = 1.0f;
+	}
+	f->F[1] = dt;
+	f->Q[1] = qSignal;
+	f->Q[2] = qCoupling;
+	f->Q[3] = qCoupling;
+	f->Q[4] = qCoupling;
+	f->R = r;
+
+	arm_mat_init_f32(&f->MatP, FUSION_STATES, FUSION_STATES, f->P);
+	arm_mat_init_f32(&f->MatF, FUSION_STATES, FUSION_STATES, f->F);
+	arm_mat_init_f32(&f->MatFt, FUSION_STATES, FUSION_STATES, f->Ft);
+	arm_mat_init_f32(&f->MatTmp, FUSION_STATES, FUSION_STATES, f->Tmp);
+	arm_mat_init_f32(&f->MatPHt, 1, FUSION_STATES, f->PHt);
+	arm_mat_init_f32(&f->MatK, FUSION_STATES, 1, f->K);
+	arm_mat_trans_f32(&f->MatF, &f->MatFt);
+
+	f->NisAvg = 1.0f;
+	f->Confidence = 0.0f;
+}
+
+void FUSION_Process(FUSION_t* f, const q15_t* ppg, uint32_t count, const LIS3DSH_Axes_t* acc, uint32_t accCount, q15_t* out) {
+	uint32_t steps = count / FUSION_DECIMATION;
+	float32_t sens = LIS3DSH_GetSensitivity();
+	float32_t a[3] = {0.0f, 0.0f, 0.0f};
+	uint32_t s, i;
+	int32_t sum;
+
+	for (s = 0; s < steps; s++) {
+		/* Average of ADC samples for this step */
+		sum = 0;
+		for (i = 0; i < FUSION_DECIMATION; i++) {
+			sum += *ppg++;
+		}
+
+		/* Nearest accelerometer sample, AC part only */
+		if (accCount) {
+			const LIS3DSH_Axes_t* ax = &acc[s * accCount / steps];
+			float32_t g[3];
+
+			g[0] = ax->X * sens;
+			g[1] = ax->Y * sens;
+			g[2] = ax->Z * sens;
+			for (i = 0; i < 3; i++) {
+				f->AccDC[i] += FUSION_DC_ALPHA * (g[i] - f->AccDC[i]);
+				a[i] = g[i] - f->AccDC[i];
+			}
+		}
+
+		FUSION_Step(f, (float32_t)sum * (1.0f / (32768.0f * FUSION_DECIMATION)), a);
+		*out++ = (q15_t)__SSAT((q31_t)(f->X[0] * 32768.0f), 16);
+	}
+}
+
+static void FUSION_Step(FUSION_t* f, float32_t y, const float32_t* a) {
+	float32_t* P = f->P;
+	float32_t* PHt = f->PHt;
+	float32_t* x = f->X;
+	float32_t S, e, m, nis, motion;
+	uint32_t i;
+
+	/* Predict, F only couples s with ds/dt */
+	x[0] += f->F[1] * x[1];
+	arm_mat_mult_f32(&f->MatF, &f->MatP, &f->MatTmp);
+	arm_mat_mult_f32(&f->MatTmp, &f->MatFt, &f->MatP);
+	for (i = 0; i < FUSION_STATES; i++) {
+		P[i * FUSION_STATES + i] += f->Q[i];
+	}
+
+	/* H = [1, 0, ax, ay, az], P * H^T computed directly from its structure */
+	for (i = 0; i < FUSION_STATES; i++) {
+		const float32_t* row = &P[i * FUSION_STATES];
+		PHt[i] = row[0] + row[2] * a[0] + row[3] * a[1] + row[4] * a[2];
+	}
+	S = PHt[0] + PHt[2] * a[0] + PHt[3] * a[1] + PHt[4] * a[2] + f->R;
+	m = x[2] * a[0] + x[3] * a[1] + x[4] * a[2];
+	e = y - x[0] - m;
+
+	/* Update, P = P - K * (P * H^T)^T */
+	arm_mat_scale_f32(&f->MatPHt, 1.0f / S, &f->MatK);
+	for (i = 0; i < FUSION_STATES; i++) {
+		x[i] += f->K[i] * e;
+	}
+	arm_mat_mult_f32(&f->MatK, &f->MatPHt, &f->MatTmp);
+	arm_mat_sub_f32(&f->MatP, &f->MatTmp, &f->MatP);
+
+	/* Confidence from filter consistency and share of motion in raw signal */
+	nis = e * e / S;
+	motion = x[2] * a[0] + x[3] * a[1] + x[4] * a[2];
+	f->NisAvg += FUSION_STAT_ALPHA * (nis - f->NisAvg);
+	f->SignalPow += FUSION_STAT_ALPHA * (x[0] * x[0] - f->SignalPow);
+	f->MotionPow += FUSION_STAT_ALPHA * (motion * motion - f->MotionPow);
+
+	f->Confidence = f->NisAvg > 1.0f ? 1.0f / f->NisAvg : 1.0f;
+	if (f->SignalPow + f->MotionPow > 0.0f) {
+		f->Confidence *= f->SignalPow / (f->SignalPow + f->MotionPow);
+	}
+}
@@ -0,0 +1,94 @@
+#ifndef FUSION_H
+#define FUSION_H 100
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Kalman filter fusing optical channel (PC1) with LIS3DSH accelerometer.
+ *
+ * Optical sample is modeled as pulse signal plus motion artifact
+ * which is linear in AC part of acceleration:
+ *
+ *   y = s + hx * ax + hy * ay + hz * az
+ *
+ * State is x = [s, ds/dt, hx, hy, hz], s follows constant-velocity model,
+ * couplings h are random walk. Measurement is scalar, so no matrix inverse is needed.
+ *
+ * Filter runs once per FUSION_DECIMATION ADC samples (120 Hz at 1920 Hz sampling).
+ * All matrices are part of @ref FUSION_t structure, nothing is allocated at run-time.
+ */
+
+#include "stm32f4xx_hal.h"
+#include "arm_math.h"
+#include "lis3dsh.h"
+
+/* Number of states */
+#define FUSION_STATES				5
+
+/* ADC samples per filter step */
+#define FUSION_DECIMATION			16
+
+/* Minimal confidence for transmitting data */
+#ifndef FUSION_CONFIDENCE_GATE
+#define FUSION_CONFIDENCE_GATE		0.5f
+#endif
+
+typedef struct {
+	float32_t X[FUSION_STATES];                   /*!< State estimate */
+	float32_t P[FUSION_STATES * FUSION_STATES];   /*!< State covariance */
+	float32_t F[FUSION_STATES * FUSION_STATES];   /*!< State transition, constant */
+	float32_t Ft[FUSION_STATES * FUSION_STATES];  /*!< Transposed state transition, constant */
+	float32_t Q[FUSION_STATES];                   /*!< Process noise diagonal, constant */
+	float32_t R;                                  /*!< Measurement noise */
+	float32_t Tmp[FUSION_STATES * FUSION_STATES]; /*!< Temporary matrix */
+	float32_t PHt[FUSION_STATES];                 /*!< P * H^T */
+	float32_t K[FUSION_STATES];                   /*!< Kalman gain */
+	arm_matrix_instance_f32 MatP, MatF, MatFt, MatTmp, MatPHt, MatK;
+	float32_t AccDC[3];                           /*!< Gravity estimate per axis in g */
+	float32_t NisAvg;                             /*!< Average normalized innovation squared, 1 for consistent filter */
+	float32_t SignalPow;                          /*!< Average power of cleaned signal */
+	float32_t MotionPow;                          /*!< Average power of removed motion artifact */
+	float32_t Confidence;                         /*!< Output confidence from 0 to 1 */
+} FUSION_t;
+
+/**
+ * @brief  Initializes fusion filter
+ * @param  *f: Pointer to @ref FUSION_t structure
+ * @param  dt: Time between filter steps in seconds
+ * @param  qSignal: Process noise of signal derivative
+ * @param  qCoupling: Process noise of motion couplings
+ * @param  r: Measurement noise of optical channel, in q15 full scale units squared
+ * @retval None
+ */
+void FUSION_Init(FUSION_t* f, float32_t dt, float32_t qSignal, float32_t qCoupling, float32_t r);
+
+/**
+ * @brief  Runs filter over one block of optical samples
+ * @note   Accelerometer samples are spread evenly over the block,
+ *         without them filter runs with zero motion reference
+ * @param  *f: Pointer to @ref FUSION_t structure
+ * @param  *ppg: Pointer to conditioned optical samples
+ * @param  count: Number of optical samples, multiple of @ref FUSION_DECIMATION
+ * @param  *acc: Pointer to accelerometer samples covering the same time span
+ * @param  accCount: Number of accelerometer samples
+ * @param  *out: Pointer to count / @ref FUSION_DECIMATION motion compensated samples
+ * @retval None
+ */
+void FUSION_Process(FUSION_t* f, const q15_t* ppg, uint32_t count, const LIS3DSH_Axes_t* acc, uint32_t accCount, q15_t* out);
+
+/**
+ * @brief  Checks if signal is good enough for transmission
+ * @param  *f: Pointer to @ref FUSION_t structure
+ * @retval 1 if confidence is at least @ref FUSION_CONFIDENCE_GATE, 0 otherwise
+ */
+#define FUSION_IsReliable(f)		((f)->Confidence >= FUSION_CONFIDENCE_GATE)
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,203 @@
+#include "hop.h"
+#include <string.h>
+
+static void HOP_ScanChunk(HOP_t* h);
+static uint8_t HOP_Score(const HOP_t* h, uint8_t channel);
+static void HOP_Snapshot(HOP_t* h);
+static void HOP_Tune(HOP_t* h, uint8_t channel);
+
+void HOP_Init(HOP_t* h, uint8_t channel) {
+	memset(h, 0, sizeof(HOP_t));
+	h->Channel = channel;
+	h->Home = channel;
+	HOP_Snapshot(h);
+	HOP_Scan(h);
+}
+
+void HOP_Scan(HOP_t* h) {
+	if (h->State != HOP_State_Idle) {
+		return;
+	}
+	memset(h->Busy, 0, sizeof(h->Busy));
+	h->Next = 0;
+	h->Sweep = 0;
+	h->State = HOP_State_Scan;
+}
+
+uint8_t HOP_Process(HOP_t* h) {
+	NRF24L01_TxStats_t stats;
+	uint32_t packets, penalty;
+	uint8_t best, score, i;
+
+	switch (h->State) {
+		case HOP_State_Scan:
+			/* Queued packets are sent on current channel first */
+			if (NRF24L01_SendPending()) {
+				return 1;
+			}
+			HOP_ScanChunk(h);
+			if (h->Sweep < HOP_SWEEPS) {
+				return 1;
+			}
+
+			h->ScanTick = HAL_GetTick();
+			HOP_Snapshot(h);
+
+			best = h->Channel;
+			score = HOP_Score(h, best);
+			for (i = 0; i < HOP_CHANNELS; i++) {
+				if (HOP_Score(h, i) + HOP_MARGIN <= score) {
+					best = i;
+					score = HOP_Score(h, i);
+				}
+			}
+			if (best != h->Channel) {
+				h->Candidate = best;
+				h->Retries = 0;
+				h->State = HOP_State_Announce;
+			} else {
+				h->State = HOP_State_Idle;
+			}
+			return 0;
+
+		case HOP_State_Confirm:
+			if (NRF24L01_SendPending()) {
+				return 1;
+			}
+			NRF24L01_GetTxStats(&stats);
+			if (stats.Sent != h->Sent && stats.Lost == h->Lost) {
+				/* Peer has the announcement, both sides hop. Urgent packet may be sent too, so nothing may be lost */
+				HOP_Tune(h, h->Candidate);
+				h->Hops++;
+				h->State = HOP_State_Idle;
+			} else if (++h->Retries < HOP_RETRIES) {
+				h->State = HOP_State_Announce;
+			} else {
+				/* Peer may have hopped with acknowledgment lost, probe is sent on new channel */
+				h->Previous = h->Channel;
+				HOP_Tune(h, h->Candidate);
+				h->State = HOP_State_Probe;
+			}
+			HOP_Snapshot(h);
+			return 0;
+
+		case HOP_State_Verify:
+			if (NRF24L01_SendPending()) {
+				return 1;
+			}
+			NRF24L01_GetTxStats(&stats);
+			if (stats.Sent != h->Sent && stats.Lost == h->Lost) {
+				/* Peer is on new channel */
+				h->Hops++;
+			} else {
+				/* Peer did not follow */
+				HOP_Tune(h, h->Previous);
+			}
+			h->State = HOP_State_Idle;
+			HOP_Snapshot(h);
+			return 0;
+
+		case HOP_State_Announce:
+		case HOP_State_Probe:
+			return 0;
+
+		default:
+			NRF24L01_GetTxStats(&stats);
+			if (stats.Sent == h->Sent && stats.Lost - h->Lost >= HOP_FALLBACK_LOST && h->Channel != h->Home &&
+				NRF24L01_SendPending() == 0) {
+				/* Peer is not reachable, it returns to home channel on its own. Channel is changed in standby only */
+				HOP_Tune(h, h->Home);
+				HOP_Snapshot(h);
+				return 0;
+			}
+
+			/* Mean retransmissions per packet over window */
+			packets = (stats.Sent - h->Sent) + (stats.Lost - h->Lost);
+			if (packets < HOP_WINDOW) {
+				return 0;
+			}
+			penalty = (stats.Retransmits - h->Retransmits) + (stats.Lost - h->Lost) * 16;
+			HOP_Snapshot(h);
+			if (penalty > packets * HOP_RESCAN_RETRANSMITS && HAL_GetTick() - h->ScanTick >= HOP_RESCAN_MIN_MS) {
+				HOP_Scan(h);
+			}
+			return 0;
+	}
+}
+
+uint8_t HOP_GetAnnounce(HOP_t* h, uint8_t* data) {
+	if ((h->State != HOP_State_Announce && h->State != HOP_State_Probe) || NRF24L01_SendPending()) {
+		return 0;
+	}
+
+	/* Acknowledgment of this packet is checked in HOP_Process() */
+	HOP_Snapshot(h);
+
+	data[0] = 'C';
+	data[1] = h->Candidate;
+	if (h->State == HOP_State_Probe) {
+		/* Radio is already on candidate channel */
+		data[2] = h->Previous;
+		h->State = HOP_State_Verify;
+	} else {
+		data[2] = h->Channel;
+		h->State = HOP_State_Confirm;
+	}
+	memset(&data[3], 0, 7);
+	return 1;
+}
+
+static void HOP_ScanChunk(HOP_t* h) {
+	uint8_t i;
+
+	for (i = 0; i < HOP_SCAN_CHUNK && h->Sweep < HOP_SWEEPS; i++) {
+		/* Channel is changed in standby, RPD is valid after dwell in RX mode */
+		NRF24L01_Standby();
+		NRF24L01_SetChannel(h->Next);
+		NRF24L01_PowerUpRx();
+		Delay(HOP_DWELL_US);
+		if (NRF24L01_Process() != NRF24L01_Mode_Rx) {
+			/* Crystal is still starting, channel is scanned on next call */
+			break;
+		}
+		if (NRF24L01_GetRPD()) {
+			h->Busy[h->Next]++;
+		}
+
+		if (++h->Next >= HOP_CHANNELS) {
+			h->Next = 0;
+			h->Sweep++;
+		}
+	}
+
+	/* Back to link channel between chunks, urgent packet may be sent before next one */
+	HOP_Tune(h, h->Channel);
+}
+
+static uint8_t HOP_Score(const HOP_t* h, uint8_t channel) {
+	uint8_t score = 2 * h->Busy[channel];
+
+	if (channel > 0) {
+		score += h->Busy[channel - 1];
+	}
+	if (channel < HOP_CHANNELS - 1) {
+		score += h->Busy[channel + 1];
+	}
+	return score;
+}
+
+static void HOP_Snapshot(HOP_t* h) {
+	NRF24L01_TxStats_t stats;
+
+	NRF24L01_GetTxStats(&stats);
+	h->Sent = stats.Sent;
+	h->Lost = stats.Lost;
+	h->Retransmits = stats.Retransmits;
+}
+
+static void HOP_Tune(HOP_t* h, uint8_t channel) {
+	NRF24L01_Standby();
+	NRF24L01_SetChannel(channel);
+	NRF24L01_PowerUpRx();
+	h->Channel = channel;
+}
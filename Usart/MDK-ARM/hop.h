@@ -0,0 +1,126 @@
+#ifndef HOP_H
+#define HOP_H 100
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Adaptive channel selection for NRF24L01+ link.
+ *
+ * Channels 0 - HOP_CHANNELS-1 are swept HOP_SWEEPS times with received power detector,
+ * radio listens HOP_DWELL_US on each channel and RPD bit is counted to occupancy map.
+ * Sweep is done in chunks of HOP_SCAN_CHUNK channels per @ref HOP_Process() call, so
+ * main loop keeps processing blocks between chunks.
+ *
+ * Channel score is twice its own occupancy plus occupancy of both neighbours, cleanest
+ * channel is taken when it beats current one by HOP_MARGIN. New channel is announced to
+ * peer with 'C' packet on current channel and radio hops only after packet is acknowledged.
+ * Radio returns to link channel after every chunk, so urgent packets go out during scan.
+ *
+ * Acknowledgment of the announcement may be lost while peer has hopped. After HOP_RETRIES
+ * unacknowledged announcements radio hops anyway and sends one 'C' probe on new channel,
+ * it stays there when probe is acknowledged and goes back otherwise. When HOP_FALLBACK_LOST
+ * packets in row are lost, radio returns to home channel given to @ref HOP_Init() without
+ * announcement.
+ *
+ * Gateway rules: hop on 'C' packet, acknowledge 'C' whose new channel is the one it is already
+ * on, and return to home channel after silence, as bracelet does after lost packets.
+ *
+ * Link is watched through @ref NRF24L01_GetTxStats(), new scan starts when mean number of
+ * retransmissions per packet over HOP_WINDOW packets exceeds HOP_RESCAN_RETRANSMITS,
+ * lost packet counts as 16 retransmissions.
+ */
+
+#include "stm32f4xx_hal.h"
+#include "nrf.h"
+
+/* Scanned channels, 2.400 - 2.525 GHz */
+#define HOP_CHANNELS				126
+
+/* Sweeps per scan and channels per call */
+#define HOP_SWEEPS					4
+#define HOP_SCAN_CHUNK				8
+
+/* Listening time per channel, RX settling and RPD delay */
+#define HOP_DWELL_US				(NRF24L01_TSTBY2A_US + 40)
+
+/* Required score improvement to hop */
+#define HOP_MARGIN					2
+
+/* Rescan trigger */
+#define HOP_WINDOW					32
+#define HOP_RESCAN_RETRANSMITS		3
+#define HOP_RESCAN_MIN_MS			10000UL
+
+/* Announcements before hop is tried without acknowledgment */
+#define HOP_RETRIES					3
+
+/* Lost packets in row before return to home channel */
+#define HOP_FALLBACK_LOST			8
+
+typedef enum {
+	HOP_State_Idle = 0x00,    /*!< Watching link quality */
+	HOP_State_Scan,           /*!< Sweeping channels, radio is reserved */
+	HOP_State_Announce,       /*!< New channel waits for announcement */
+	HOP_State_Confirm,        /*!< Announcement sent, waiting for acknowledgment */
+	HOP_State_Probe,          /*!< Hopped without acknowledgment, probe waits for sending */
+	HOP_State_Verify          /*!< Probe sent on new channel, waiting for acknowledgment */
+} HOP_State_t;
+
+typedef struct {
+	HOP_State_t State;        /*!< Current state */
+	uint8_t Channel;          /*!< Channel of link */
+	uint8_t Candidate;        /*!< Channel to hop to */
+	uint8_t Previous;         /*!< Channel before unconfirmed hop */
+	uint8_t Home;             /*!< Channel to return to when peer is lost */
+	uint8_t Busy[HOP_CHANNELS]; /*!< Number of sweeps with carrier on channel */
+	uint8_t Next;             /*!< Next channel to scan */
+	uint8_t Sweep;            /*!< Completed sweeps */
+	uint8_t Retries;          /*!< Announcements sent for candidate */
+	uint32_t Sent;            /*!< Sent packets at window start */
+	uint32_t Lost;            /*!< Lost packets at window start */
+	uint32_t Retransmits;     /*!< Retransmissions at window start */
+	uint32_t ScanTick;        /*!< HAL tick of last scan */
+	uint16_t Hops;            /*!< Number of hops */
+} HOP_t;
+
+/**
+ * @brief  Initializes channel selection and requests first scan
+ * @param  *h: Pointer to @ref HOP_t structure
+ * @param  channel: Channel set by @ref NRF24L01_Init(), it is also home channel
+ * @retval None
+ */
+void HOP_Init(HOP_t* h, uint8_t channel);
+
+/**
+ * @brief  Requests channel scan, started when no packet is pending
+ * @param  *h: Pointer to @ref HOP_t structure
+ * @retval None
+ */
+void HOP_Scan(HOP_t* h);
+
+/**
+ * @brief  Advances scan and hop, watches link quality, call from main loop
+ * @param  *h: Pointer to @ref HOP_t structure
+ * @retval 1 when radio is reserved and no packet may be sent, 0 otherwise
+ */
+uint8_t HOP_Process(HOP_t* h);
+
+/**
+ * @brief  Packs announcement of new channel when it should be sent
+ * @note   Layout: 'C', new channel, channel before hop, 7 bytes zero. Packet must be sent
+ *         with @ref NRF24L01_Send() right after this function returns 1
+ * @param  *h: Pointer to @ref HOP_t structure
+ * @param  *data: Pointer to 10 bytes output buffer
+ * @retval 1 if announcement was packed, 0 otherwise
+ */
+uint8_t HOP_GetAnnounce(HOP_t* h, uint8_t* data);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,323 @@
+#include "hrv.h"
+#include <math.h>
+
+/* Baseline removal factor per sample */
+#define HRV_DC_ALPHA				0.02f
+
+/* Peak amplitude decay per sample and detection threshold relative to it */
+#define HRV_AMP_DECAY				0.998f
+#define HRV_THRESHOLD				0.5f
+
+/* Minimal peak amplitude, q15 full scale is 1 */
+#define HRV_AMP_MIN					0.001f
+
+/* Successive differences above this are counted for pNN50 */
+#define HRV_NN50_MS					50
+
+/* Number of rejected intervals after which reference is restarted */
+#define HRV_REJECT_RESTART			5
+
+/* Gap in tachogram which restarts resampling, in seconds */
+#define HRV_TACHO_GAP				3.0f
+
+/* Frequency bands in Hz */
+#define HRV_LF_LOW					0.04f
+#define HRV_LF_HIGH					0.15f
+#define HRV_HF_HIGH					0.4f
+
+/* Private functions */
+static void HRV_Beat(HRV_t* h);
+static void HRV_Interval(HRV_t* h, float32_t rr);
+static void HRV_AddInterval(HRV_t* h, uint16_t rr, uint8_t diffValid);
+static void HRV_RemoveOldest(HRV_t* h);
+static void HRV_Resample(HRV_t* h, float32_t dt, float32_t rr);
+static void HRV_Spectrum(HRV_t* h);
+
+void HRV_Init(HRV_t* h, float32_t fs) {
+	uint32_t i;
+
+	memset(h, 0, sizeof(HRV_t));
+	h->Fs = fs;
+
+	for (i = 0; i < HRV_FFT_SIZE; i++) {
+		h->Window[i] = 0.5f - 0.5f * cosf(2.0f * PI * i / (HRV_FFT_SIZE - 1));
+	}
+	FFT_RfftInit_f32(&h->Fft, HRV_FFT_SIZE);
+}
+
+uint32_t HRV_Process(HRV_t* h, const q15_t* x, uint32_t count) {
+	uint32_t beats = 0;
+	float32_t v, y, thr;
+
+	while (count-- > 0) {
+		v = (float32_t)*x++ * (1.0f / 32768.0f);
+		h->Dc += HRV_DC_ALPHA * (v - h->Dc);
+		y = v - h->Dc;
+
+		h->Amp *= HRV_AMP_DECAY;
+		if (y > h->Amp) {
+			h->Amp = y;
+		}
+		thr = HRV_THRESHOLD * h->Amp;
+
+		if (y > thr && h->Amp > HRV_AMP_MIN) {
+			if (!h->InPeak || y > h->MaxVal) {
+				/* New peak candidate */
+				h->InPeak = 1;
+				h->MaxPrev = h->Prev;
+				h->MaxVal = y;
+				h->MaxNext = y;
+				h->MaxTime = h->Time;
+			} else if (h->Time == h->MaxTime + 1) {
+				h->MaxNext = y;
+			}
+		} else if (h->InPeak) {
+			/* Signal fell below threshold, peak is complete */
+			if (h->Time == h->MaxTime + 1) {
+				h->MaxNext = y;
+			}
+			h->InPeak = 0;
+			HRV_Beat(h);
+			beats++;
+		}
+
+		h->Prev = y;
+		h->Time++;
+	}
+
+	return beats;
+}
+
+void HRV_Calculate(HRV_t* h, HRV_Summary_t* s) {
+	uint64_t n = h->Count;
+
+	memset(s, 0, sizeof(HRV_Summary_t));
+	s->Beats = h->Count;
+	if (n == 0) {
+		return;
+	}
+
+	s->MeanRR = (uint16_t)(h->SumRR / n);
+	if (n > 1) {
+		/* Exact integer variance, n * sum(x^2) - sum(x)^2 */
+		uint64_t num = n * h->SumRR2 - (uint64_t)h->SumRR * h->SumRR;
+		s->SDNN = sqrtf((float32_t)num / (float32_t)(n * (n - 1)));
+	}
+	if (h->CountSD) {
+		s->RMSSD = sqrtf((float32_t)h->SumSD2 / h->CountSD);
+		s->PNN50 = 100.0f * h->CountNN50 / h->CountSD;
+	}
+	if (h->HF > 0.0f) {
+		s->LFHF = h->LF / h->HF;
+	}
+}
+
+uint8_t HRV_GetSummary(HRV_t* h, HRV_Summary_t* s) {
+	if ((float32_t)(h->Time - h->SummaryTime) < h->Fs * (HRV_SUMMARY_MS / 1000)) {
+		return 0;
+	}
+	h->SummaryTime = h->Time;
+	HRV_Calculate(h, s);
+	return 1;
+}
+
+void HRV_Pack(const HRV_Summary_t* s, uint8_t* data) {
+	uint16_t sdnn = (uint16_t)__USAT((int32_t)(s->SDNN * 10.0f), 16);
+	uint16_t rmssd = (uint16_t)__USAT((int32_t)(s->RMSSD * 10.0f), 16);
+	uint16_t lfhf = (uint16_t)__USAT((int32_t)(s->LFHF * 100.0f), 16);
+
+	data[0] = 'H';
+	data[1] = (uint8_t)s->MeanRR;
+	data[2] = (uint8_t)(s->MeanRR >> 8);
+	data[3] = (uint8_t)sdnn;
+	data[4] = (uint8_t)(sdnn >> 8);
+	data[5] = (uint8_t)rmssd;
+	data[6] = (uint8_t)(rmssd >> 8);
+	data[7] = (uint8_t)s->PNN50;
+	data[8] = (uint8_t)lfhf;
+	data[9] = (uint8_t)(lfhf >> 8);
+}
+
+/* Peak is complete, refine its time and measure interval */
+static void HRV_Beat(HRV_t* h) {
+	float32_t den = h->MaxPrev - 2.0f * h->MaxVal + h->MaxNext;
+	float32_t frac = 0.0f;
+	float32_t rr;
+
+	/* Parabolic interpolation of peak position */
+	if (den < 0.0f) {
+		float32_t d = 0.5f * (h->MaxPrev - h->MaxNext) / den;
+		if (d > -0.5f && d < 0.5f) {
+			frac = d;
+		}
+	}
+
+	if (h->BeatValid) {
+		/* Integer sample difference keeps sub-sample precision however long device runs */
+		rr = ((float32_t)(int32_t)(h->MaxTime - h->LastBeat) + frac - h->LastFrac) * 1000.0f / h->Fs;
+		if (rr < HRV_RR_MIN_MS) {
+			/* Secondary peak of the same beat */
+			return;
+		}
+		HRV_Interval(h, rr);
+	}
+	h->LastBeat = h->MaxTime;
+	h->LastFrac = frac;
+	h->BeatValid = 1;
+}
+
+/* Ectopic beat rejection */
+static void HRV_Interval(HRV_t* h, float32_t rr) {
+	uint16_t r = (uint16_t)(rr + 0.5f);
+
+	h->TachoElapsed += rr * 0.001f;
+
+	if (rr > HRV_RR_MAX_MS ||
+		(h->RRAvg > 0.0f && fabsf(rr - h->RRAvg) > h->RRAvg * (HRV_ECTOPIC_PERCENT / 100.0f))) {
+		/* Restart reference if rhythm really changed */
+		if (++h->Rejected >= HRV_REJECT_RESTART) {
+			h->RRAvg = 0.0f;
+		}
+		h->LastAccepted = 0;
+		return;
+	}
+
+	h->Rejected = 0;
+	h->RRAvg = h->RRAvg > 0.0f ? h->RRAvg + 0.125f * (rr - h->RRAvg) : rr;
+	HRV_AddInterval(h, r, h->LastAccepted);
+	h->LastAccepted = 1;
+	HRV_Resample(h, h->TachoElapsed, rr);
+	h->TachoElapsed = 0.0f;
+}
+
+static void HRV_AddInterval(HRV_t* h, uint16_t rr, uint8_t diffValid) {
+	uint16_t idx, prev;
+	int16_t d;
+
+	while (h->Count && (h->SumRR + rr > HRV_WINDOW_MS || h->Count == HRV_MAX_BEATS)) {
+		HRV_RemoveOldest(h);
+	}
+
+	idx = h->Head + h->Count;
+	if (idx >= HRV_MAX_BEATS) {
+		idx -= HRV_MAX_BEATS;
+	}
+	prev = idx ? idx - 1 : HRV_MAX_BEATS - 1;
+
+	h->RR[idx] = rr;
+	h->SumRR += rr;
+	h->SumRR2 += (uint32_t)rr * rr;
+
+	h->DiffValid[idx] = diffValid && h->Count;
+	if (h->DiffValid[idx]) {
+		d = (int16_t)(rr - h->RR[prev]);
+		h->Diff[idx] = d;
+		h->SumSD2 += (uint32_t)(d * d);
+		h->CountSD++;
+		if (d > HRV_NN50_MS || d < -HRV_NN50_MS) {
+			h->CountNN50++;
+		}
+	}
+	h->Count++;
+}
+
+static void HRV_RemoveOldest(HRV_t* h) {
+	uint16_t i = h->Head, next;
+	int16_t d;
+
+	h->SumRR -= h->RR[i];
+	h->SumRR2 -= (uint32_t)h->RR[i] * h->RR[i];
+
+	/* Difference of next interval refers to removed one */
+	next = i + 1 < HRV_MAX_BEATS ? i + 1 : 0;
+	if (h->Count > 1 && h->DiffValid[next]) {
+		d = h->Diff[next];
+		h->SumSD2 -= (uint32_t)(d * d);
+		h->CountSD--;
+		if (d > HRV_NN50_MS || d < -HRV_NN50_MS) {
+			h->CountNN50--;
+		}
+		h->DiffValid[next] = 0;
+	}
+
+	h->Head = next;
+	h->Count--;
+}
+
+/* Linear interpolation of tachogram to uniform grid, time origin is previous accepted beat */
+static void HRV_Resample(HRV_t* h, float32_t dt, float32_t rr) {
+	if (h->TachoPrevRR == 0.0f || dt > HRV_TACHO_GAP) {
+		h->TachoCount = 0;
+		h->TachoNew = 0;
+		h->TachoTime = dt;
+	}
+
+	while (h->TachoTime <= dt) {
+		float32_t v = rr;
+		if (dt > 0.0f && h->TachoPrevRR > 0.0f) {
+			v = h->TachoPrevRR + (rr - h->TachoPrevRR) * h->TachoTime / dt;
+		}
+
+		h->Tacho[h->TachoIdx] = v;
+		if (++h->TachoIdx == HRV_FFT_SIZE) {
+			h->TachoIdx = 0;
+		}
+		if (h->TachoCount < HRV_FFT_SIZE) {
+			h->TachoCount++;
+		}
+		if (h->TachoCount == HRV_FFT_SIZE && ++h->TachoNew >= HRV_FFT_HOP) {
+			h->TachoNew = 0;
+			HRV_Spectrum(h);
+		}
+
+		h->TachoTime += 1.0f / HRV_RESAMPLE_HZ;
+	}
+
+	/* Rebase to this beat, so times stay small and precise */
+	h->TachoTime -= dt;
+	h->TachoPrevRR = rr;
+}
+
+/* Band powers of last HRV_FFT_SIZE resampled values, averaged over window */
+static void HRV_Spectrum(HRV_t* h) {
+	const float32_t alpha = (float32_t)HRV_FFT_HOP / (HRV_WINDOW_MS / 1000 * HRV_RESAMPLE_HZ);
+	float32_t mean = 0.0f, lf = 0.0f, hf = 0.0f, f, p;
+	uint32_t i, j;
+
+	/* Oldest value is at write position */
+	for (i = 0, j = h->TachoIdx; i < HRV_FFT_SIZE; i++) {
+		h->FftIn[i] = h->Tacho[j];
+		mean += h->Tacho[j];
+		if (++j == HRV_FFT_SIZE) {
+			j = 0;
+		}
+	}
+	mean /= HRV_FFT_SIZE;
+	for (i = 0; i < HRV_FFT_SIZE; i++) {
+		h->FftIn[i] = (h->FftIn[i] - mean) * h->Window[i];
+	}
+
+	arm_rfft_fast_f32(&h->Fft, h->FftIn, h->FftOut, 0);
+
+	/* Output is packed as DC, Nyquist, then real and imaginary part of each bin */
+	for (i = 1; i < HRV_FFT_SIZE / 2; i++) {
+		f = (float32_t)i * HRV_RESAMPLE_HZ / HRV_FFT_SIZE;
+		if (f >= HRV_HF_HIGH) {
+			break;
+		}
+		p = h->FftOut[2 * i] * h->FftOut[2 * i] + h->FftOut[2 * i + 1] * h->FftOut[2 * i + 1];
+		if (f >= HRV_LF_HIGH) {
+			hf += p;
+		} else if (f >= HRV_LF_LOW) {
+			lf += p;
+		}
+	}
+
+	if (h->LF == 0.0f && h->HF == 0.0f) {
+		h->LF = lf;
+		h->HF = hf;
+	} else {
+		h->LF += alpha * (lf - h->LF);
+		h->HF += alpha * (hf - h->HF);
+	}
+}
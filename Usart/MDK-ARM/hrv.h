@@ -0,0 +1,161 @@
+#ifndef HRV_H
+#define HRV_H 100
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Streaming heart rate variability from optical pulse signal.
+ *
+ * Beats are detected as signal peaks above adaptive threshold, peak time is refined
+ * with parabolic interpolation. RR intervals outside physiological range or differing
+ * more than HRV_ECTOPIC_PERCENT from recent average are rejected as ectopic.
+ *
+ * Time domain features are kept as running sums over last HRV_WINDOW_MS of accepted
+ * intervals, so each beat costs O(1):
+ *  - SDNN:  standard deviation of RR intervals
+ *  - RMSSD: root mean square of successive differences
+ *  - pNN50: percentage of successive differences larger than 50 ms
+ *
+ * For LF/HF ratio RR intervals are resampled to HRV_RESAMPLE_HZ, every HRV_FFT_HOP new
+ * samples last HRV_FFT_SIZE samples are transformed with arm_rfft_fast_f32() and
+ * band powers are averaged over the window.
+ */
+
+#include "stm32f4xx_hal.h"
+#include "arm_math.h"
+#include "fft.h"
+
+/* Length of rolling window in milliseconds, 5 minutes */
+#define HRV_WINDOW_MS				300000UL
+
+/* Maximal number of beats in window, enough for 200 bpm */
+#define HRV_MAX_BEATS				1024
+
+/* Physiological RR interval limits in milliseconds */
+#define HRV_RR_MIN_MS				300
+#define HRV_RR_MAX_MS				2000
+
+/* Maximal deviation of RR interval from recent average */
+#define HRV_ECTOPIC_PERCENT			20
+
+/* Tachogram resampling for frequency domain */
+#define HRV_RESAMPLE_HZ				4
+#define HRV_FFT_SIZE				256
+#define HRV_FFT_HOP					64
+
+/* Interval between summaries in milliseconds */
+#define HRV_SUMMARY_MS				60000UL
+
+/* Size of packed summary */
+#define HRV_PACKED_SIZE				10
+
+typedef struct {
+	uint16_t MeanRR;   /*!< Mean RR interval in ms */
+	float32_t SDNN;    /*!< Standard deviation of RR intervals in ms */
+	float32_t RMSSD;   /*!< Root mean square of successive differences in ms */
+	float32_t PNN50;   /*!< Percentage of successive differences above 50 ms */
+	float32_t LFHF;    /*!< Ratio of low (0.04-0.15 Hz) and high (0.15-0.4 Hz) frequency power */
+	uint16_t Beats;    /*!< Number of accepted beats in window */
+} HRV_Summary_t;
+
+typedef struct {
+	/* Beat detector */
+	float32_t Fs;                         /*!< Input sample rate in Hz */
+	uint32_t Time;                        /*!< Input sample counter */
+	float32_t Dc;                         /*!< Baseline estimate */
+	float32_t Amp;                        /*!< Decaying peak amplitude */
+	float32_t Prev;                       /*!< Previous sample */
+	float32_t MaxPrev, MaxVal, MaxNext;   /*!< Samples around current peak candidate */
+	uint32_t MaxTime;                     /*!< Sample index of peak candidate */
+	uint8_t InPeak;                       /*!< Signal is above threshold */
+	uint32_t LastBeat;                    /*!< Sample index of last detected beat */
+	float32_t LastFrac;                   /*!< Refined offset of last beat from its sample index */
+	uint8_t BeatValid;                    /*!< Last beat was detected */
+
+	/* Ectopic rejection */
+	float32_t RRAvg;                      /*!< Average of accepted intervals */
+	uint8_t Rejected;                     /*!< Number of consecutive rejected intervals */
+	uint8_t LastAccepted;                 /*!< Last interval was accepted */
+
+	/* Window of accepted intervals */
+	uint16_t RR[HRV_MAX_BEATS];           /*!< RR intervals in ms */
+	int16_t Diff[HRV_MAX_BEATS];          /*!< Difference to previous interval */
+	uint8_t DiffValid[HRV_MAX_BEATS];     /*!< Previous interval was accepted and is still in window */
+	uint16_t Head;                        /*!< Oldest interval */
+	uint16_t Count;                       /*!< Number of intervals */
+	uint32_t SumRR;                       /*!< Sum of intervals */
+	uint64_t SumRR2;                      /*!< Sum of squared intervals */
+	uint64_t SumSD2;                      /*!< Sum of squared successive differences */
+	uint16_t CountSD;                     /*!< Number of successive differences */
+	uint16_t CountNN50;                   /*!< Number of successive differences above 50 ms */
+
+	/* Frequency domain */
+	float32_t TachoTime;                  /*!< Time of next resampled value after last accepted beat in seconds */
+	float32_t TachoElapsed;               /*!< Time since last accepted beat in seconds */
+	float32_t TachoPrevRR;                /*!< Last accepted interval in ms */
+	float32_t Tacho[HRV_FFT_SIZE];        /*!< Resampled intervals, ring buffer */
+	uint16_t TachoIdx;                    /*!< Write position in ring buffer */
+	uint16_t TachoCount;                  /*!< Number of values, up to HRV_FFT_SIZE */
+	uint16_t TachoNew;                    /*!< New values since last transform */
+	float32_t Window[HRV_FFT_SIZE];       /*!< Hann window */
+	float32_t FftIn[HRV_FFT_SIZE];        /*!< Transform input */
+	float32_t FftOut[HRV_FFT_SIZE];       /*!< Transform output */
+	arm_rfft_fast_instance_f32 Fft;       /*!< Real FFT instance */
+	float32_t LF;                         /*!< Averaged low frequency power */
+	float32_t HF;                         /*!< Averaged high frequency power */
+
+	uint32_t SummaryTime;                 /*!< Sample counter at last summary */
+} HRV_t;
+
+/**
+ * @brief  Initializes HRV engine
+ * @param  *h: Pointer to @ref HRV_t structure
+ * @param  fs: Sample rate of input signal in Hz
+ * @retval None
+ */
+void HRV_Init(HRV_t* h, float32_t fs);
+
+/**
+ * @brief  Processes block of pulse signal samples
+ * @param  *h: Pointer to @ref HRV_t structure
+ * @param  *x: Pointer to samples
+ * @param  count: Number of samples
+ * @retval Number of beats detected in block
+ */
+uint32_t HRV_Process(HRV_t* h, const q15_t* x, uint32_t count);
+
+/**
+ * @brief  Calculates features over current window
+ * @param  *h: Pointer to @ref HRV_t structure
+ * @param  *s: Pointer to @ref HRV_Summary_t where features are saved
+ * @retval None
+ */
+void HRV_Calculate(HRV_t* h, HRV_Summary_t* s);
+
+/**
+ * @brief  Gets summary once every @ref HRV_SUMMARY_MS of processed signal
+ * @param  *h: Pointer to @ref HRV_t structure
+ * @param  *s: Pointer to @ref HRV_Summary_t where features are saved
+ * @retval 1 if new summary is available, 0 otherwise
+ */
+uint8_t HRV_GetSummary(HRV_t* h, HRV_Summary_t* s);
+
+/**
+ * @brief  Packs summary for radio transmission, little endian:
+ *          - 'H', mean RR [ms] (16 bits), SDNN [0.1 ms] (16 bits), RMSSD [0.1 ms] (16 bits),
+ *            pNN50 [%] (8 bits), LF/HF [0.01] (16 bits)
+ * @param  *s: Pointer to @ref HRV_Summary_t structure
+ * @param  *data: Pointer to @ref HRV_PACKED_SIZE bytes
+ * @retval None
+ */
+void HRV_Pack(const HRV_Summary_t* s, uint8_t* data);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
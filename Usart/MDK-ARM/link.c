@@ -0,0 +1,214 @@
+#include "link.h"
+#include <string.h>
+
+/* No probe in progress */
+#define LINK_NO_PROBE				LINK_PROFILES
+
+/*
+ * Energy of attempt = Itx * (130us + packet airtime) + Irx * (130us + ACK airtime).
+ * Frame is 8 bits preamble, 5 bytes address, 9 bits control field and 1 byte CRC
+ * (NRF24L01_CONFIG sets EN_CRC with CRCO=0), so 10 bytes packet is 145 bits and
+ * ACK 65 bits on air. Itx 7.0/7.5/9.0/11.3mA at -18/-12/-6/0dBm, Irx 13.5/13.1/12.6mA
+ * at 2M/1M/250k. Table must be recomputed when CRC length or address width changes.
+ */
+static const LINK_Profile_t LINK_Table[LINK_PROFILES] = {
+	{NRF24L01_DataRate_2M,   NRF24L01_OutputPower_M18dBm, 500,  5,  3611},
+	{NRF24L01_DataRate_2M,   NRF24L01_OutputPower_M12dBm, 500,  5,  3713},
+	{NRF24L01_DataRate_2M,   NRF24L01_OutputPower_M6dBm,  500,  8,  4016},
+	{NRF24L01_DataRate_2M,   NRF24L01_OutputPower_0dBm,   500,  10, 4482},
+	{NRF24L01_DataRate_1M,   NRF24L01_OutputPower_0dBm,   500,  15, 5662},
+	{NRF24L01_DataRate_250k, NRF24L01_OutputPower_0dBm,   1500, 15, 12937}
+};
+
+static void LINK_Apply(LINK_t* l, uint8_t profile);
+static void LINK_Change(LINK_t* l, uint8_t profile);
+static void LINK_Window(LINK_t* l, const NRF24L01_TxStats_t* stats);
+static void LINK_Snapshot(LINK_t* l);
+
+void LINK_Init(LINK_t* l, uint8_t profile) {
+	memset(l, 0, sizeof(LINK_t));
+	if (profile >= LINK_PROFILES) {
+		profile = LINK_PROFILES - 1;
+	}
+	l->Previous = LINK_NO_PROBE;
+	l->Hold = LINK_GOOD_WINDOWS;
+	LINK_Apply(l, profile);
+	l->Summary.Changes = 0;
+	l->SummaryTick = HAL_GetTick();
+}
+
+uint8_t LINK_Process(LINK_t* l) {
+	NRF24L01_TxStats_t stats;
+
+	switch (l->State) {
+		case LINK_State_Confirm:
+			if (NRF24L01_SendPending()) {
+				return 1;
+			}
+			NRF24L01_GetTxStats(&stats);
+			if (stats.Sent != l->Sent && stats.Lost == l->Lost) {
+				/* Peer has the announcement, both sides change data rate. Urgent packet may be sent too, so nothing may be lost */
+				LINK_Apply(l, l->Target);
+				l->State = LINK_State_Idle;
+			} else if (++l->Retries < LINK_RETRIES) {
+				l->State = LINK_State_Announce;
+			} else {
+				l->Previous = LINK_NO_PROBE;
+				l->State = LINK_State_Idle;
+			}
+			LINK_Snapshot(l);
+			return 0;
+
+		case LINK_State_Announce:
+			return 0;
+
+		default:
+			/* Settings are changed in standby only */
+			if (NRF24L01_SendPending()) {
+				return 0;
+			}
+			NRF24L01_GetTxStats(&stats);
+			if (stats.Sent == l->Sent && stats.Lost - l->Lost >= LINK_FALLBACK_LOST && l->Profile != LINK_PROFILES - 1) {
+				/* Peer is not reachable, it falls back on its own */
+				l->Previous = LINK_NO_PROBE;
+				l->Good = 0;
+				LINK_Apply(l, LINK_PROFILES - 1);
+				return 0;
+			}
+			if ((stats.Sent - l->Sent) + (stats.Lost - l->Lost) >= LINK_WINDOW) {
+				LINK_Window(l, &stats);
+			}
+			return 0;
+	}
+}
+
+uint8_t LINK_GetAnnounce(LINK_t* l, uint8_t* data) {
+	if (l->State != LINK_State_Announce || NRF24L01_SendPending()) {
+		return 0;
+	}
+
+	/* Acknowledgment of this packet is checked in LINK_Process() */
+	LINK_Snapshot(l);
+	l->State = LINK_State_Confirm;
+
+	data[0] = 'R';
+	data[1] = (uint8_t)LINK_Table[l->Target].DataRate;
+	data[2] = (uint8_t)LINK_Table[l->Target].OutPwr;
+	data[3] = l->Target;
+	memset(&data[4], 0, 6);
+	return 1;
+}
+
+uint8_t LINK_GetSummary(LINK_t* l, LINK_Summary_t* s) {
+	if (HAL_GetTick() - l->SummaryTick < LINK_SUMMARY_MS) {
+		return 0;
+	}
+	l->SummaryTick = HAL_GetTick();
+	*s = l->Summary;
+	return 1;
+}
+
+void LINK_Pack(const LINK_Summary_t* s, uint8_t* data) {
+	uint16_t energy = s->Energy > 0xFFFF ? 0xFFFF : (uint16_t)s->Energy;
+
+	data[0] = 'L';
+	data[1] = s->Profile;
+	data[2] = (uint8_t)s->Loss;
+	data[3] = (uint8_t)(s->Loss >> 8);
+	data[4] = (uint8_t)s->Retransmits;
+	data[5] = (uint8_t)(s->Retransmits >> 8);
+	data[6] = (uint8_t)energy;
+	data[7] = (uint8_t)(energy >> 8);
+	data[8] = (uint8_t)s->Changes;
+	data[9] = (uint8_t)(s->Changes >> 8);
+}
+
+static void LINK_Apply(LINK_t* l, uint8_t profile) {
+	const LINK_Profile_t* p = &LINK_Table[profile];
+
+	NRF24L01_Standby();
+	NRF24L01_SetRF(p->DataRate, p->OutPwr);
+	NRF24L01_SetRetransmit(p->Delay, p->Count);
+	NRF24L01_PowerUpRx();
+
+	l->Profile = profile;
+	l->Summary.Profile = profile;
+	l->Summary.Changes++;
+	LINK_Snapshot(l);
+}
+
+static void LINK_Change(LINK_t* l, uint8_t profile) {
+	if (profile == l->Profile) {
+		return;
+	}
+	if (LINK_Table[profile].DataRate != LINK_Table[l->Profile].DataRate) {
+		/* Peer must follow, applied after acknowledgment */
+		l->Target = profile;
+		l->Retries = 0;
+		l->State = LINK_State_Announce;
+	} else {
+		LINK_Apply(l, profile);
+	}
+}
+
+static void LINK_Window(LINK_t* l, const NRF24L01_TxStats_t* stats) {
+	uint32_t sent = stats->Sent - l->Sent;
+	uint32_t lost = stats->Lost - l->Lost;
+	uint32_t retransmits = stats->Retransmits - l->Retransmits;
+	uint32_t packets = sent + lost;
+	uint32_t energy;
+	uint8_t next = l->Profile;
+
+	/* Every packet is one attempt plus its retransmissions */
+	energy = sent ? (packets + retransmits) * LINK_Table[l->Profile].Energy / sent : 0xFFFFFFFF;
+	l->Energy[l->Profile] = energy;
+
+	l->Summary.Sent = stats->Sent;
+	l->Summary.Lost = stats->Lost;
+	l->Summary.Loss = (uint16_t)(lost * 1000 / packets);
+	l->Summary.Retransmits = (uint16_t)(retransmits * 100 / packets);
+	l->Summary.Energy = energy;
+	LINK_Snapshot(l);
+
+	if (l->Summary.Loss > LINK_LOSS_UP || l->Summary.Retransmits > LINK_ARC_UP) {
+		/* Bad window, failed probe goes back, otherwise one profile up */
+		l->Good = 0;
+		if (l->Previous != LINK_NO_PROBE) {
+			next = l->Previous;
+			l->Hold = l->Hold * 2 > LINK_GOOD_WINDOWS_MAX ? LINK_GOOD_WINDOWS_MAX : l->Hold * 2;
+		} else if (l->Profile < LINK_PROFILES - 1) {
+			next = l->Profile + 1;
+		}
+		l->Previous = LINK_NO_PROBE;
+	} else if (l->Previous != LINK_NO_PROBE) {
+		/* Probe is kept only when delivered packet costs less energy */
+		if (energy > l->Energy[l->Previous]) {
+			next = l->Previous;
+			l->Hold = l->Hold * 2 > LINK_GOOD_WINDOWS_MAX ? LINK_GOOD_WINDOWS_MAX : l->Hold * 2;
+		} else {
+			l->Hold = LINK_GOOD_WINDOWS;
+		}
+		l->Previous = LINK_NO_PROBE;
+		l->Good = 0;
+	} else if (lost == 0 && l->Summary.Retransmits < LINK_ARC_DOWN) {
+		/* Clean window, probe cheaper profile after enough of them */
+		if (l->Profile > 0 && ++l->Good >= l->Hold) {
+			l->Good = 0;
+			l->Previous = l->Profile;
+			next = l->Profile - 1;
+		}
+	} else {
+		l->Good = 0;
+	}
+
+	LINK_Change(l, next);
+}
+
+static void LINK_Snapshot(LINK_t* l) {
+	NRF24L01_TxStats_t stats;
+
+	NRF24L01_GetTxStats(&stats);
+	l->Sent = stats.Sent;
+	l->Lost = stats.Lost;
+	l->Retransmits = stats.Retransmits;
+}
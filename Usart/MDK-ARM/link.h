@@ -0,0 +1,151 @@
+#ifndef LINK_H
+#define LINK_H 100
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Adaptive data rate, output power and retransmission of NRF24L01+ link.
+ *
+ * Radio settings are ordered in profiles from cheapest to most robust, every profile
+ * sets data rate, output power, retransmit delay and retransmit count. Energy of one
+ * attempt is estimated from datasheet currents and airtime of 10 bytes packet and its
+ * acknowledgment.
+ *
+ * Link is measured through @ref NRF24L01_GetTxStats() over LINK_WINDOW streamed packets:
+ *  - loss ratio from packets dropped after MAX_RT
+ *  - mean ARC_CNT, retransmissions per packet
+ *  - energy per delivered packet, attempts times energy of attempt divided by delivered packets
+ *
+ * Bad window (loss or mean retransmissions above limit) steps to more robust profile at once.
+ * After LINK_GOOD_WINDOWS clean windows cheaper profile is probed, probe is kept only when
+ * it delivers packets with less energy than profile before it, otherwise link goes back and
+ * next probe waits twice as long. This keeps goodput per joule at maximum.
+ *
+ * Output power and retransmission are local settings. Data rate must match on both sides,
+ * so its change is announced to peer with 'R' packet and applied only after acknowledgment.
+ * When LINK_FALLBACK_LOST packets in row are lost, link falls back to most robust profile
+ * without announcement, gateway must do the same after silence.
+ */
+
+#include "stm32f4xx_hal.h"
+#include "nrf.h"
+
+/* Number of profiles */
+#define LINK_PROFILES				6
+
+/* Streamed packets per measurement window */
+#define LINK_WINDOW					32
+
+/* Bad window, loss in permille and mean retransmissions x100 */
+#define LINK_LOSS_UP				20
+#define LINK_ARC_UP					150
+
+/* Good window, no loss and mean retransmissions x100 */
+#define LINK_ARC_DOWN				20
+
+/* Clean windows before cheaper profile is probed, doubled after failed probe */
+#define LINK_GOOD_WINDOWS			4
+#define LINK_GOOD_WINDOWS_MAX		64
+
+/* Lost packets in row before fallback to most robust profile */
+#define LINK_FALLBACK_LOST			8
+
+/* Announcements before data rate change is given up */
+#define LINK_RETRIES				3
+
+/* Summary interval */
+#define LINK_SUMMARY_MS				60000UL
+
+typedef enum {
+	LINK_State_Idle = 0x00,   /*!< Measuring link */
+	LINK_State_Announce,      /*!< Data rate change waits for announcement */
+	LINK_State_Confirm        /*!< Announcement sent, waiting for acknowledgment */
+} LINK_State_t;
+
+typedef struct {
+	NRF24L01_DataRate_t DataRate;    /*!< Data rate */
+	NRF24L01_OutputPower_t OutPwr;   /*!< Output power */
+	uint16_t Delay;                  /*!< Retransmit delay in us */
+	uint8_t Count;                   /*!< Maximum number of retransmissions */
+	uint16_t Energy;                 /*!< Estimated energy of one attempt in nC */
+} LINK_Profile_t;
+
+typedef struct {
+	uint8_t Profile;          /*!< Active profile, 0 is cheapest */
+	uint32_t Sent;            /*!< Delivered packets since start */
+	uint32_t Lost;            /*!< Lost packets since start */
+	uint16_t Loss;            /*!< Loss in last window in permille */
+	uint16_t Retransmits;     /*!< Mean retransmissions per packet in last window x100 */
+	uint32_t Energy;          /*!< Energy per delivered packet in last window in nC */
+	uint16_t Changes;         /*!< Number of profile changes */
+} LINK_Summary_t;
+
+typedef struct {
+	LINK_State_t State;       /*!< Current state */
+	uint8_t Profile;          /*!< Active profile */
+	uint8_t Target;           /*!< Profile waiting for announcement */
+	uint8_t Previous;         /*!< Profile before probe, LINK_PROFILES when no probe runs */
+	uint8_t Retries;          /*!< Announcements sent for target */
+	uint8_t Good;             /*!< Clean windows in row */
+	uint8_t Hold;             /*!< Clean windows required before probe */
+	uint32_t Sent;            /*!< Delivered packets at window start */
+	uint32_t Lost;            /*!< Lost packets at window start */
+	uint32_t Retransmits;     /*!< Retransmissions at window start */
+	uint32_t Energy[LINK_PROFILES]; /*!< Last measured energy per delivered packet, 0 if unknown */
+	LINK_Summary_t Summary;   /*!< Statistics of last window */
+	uint32_t SummaryTick;     /*!< HAL tick of last summary */
+} LINK_t;
+
+/**
+ * @brief  Initializes link controller and applies profile
+ * @note   Radio must be initialized with @ref NRF24L01_Init() and peer must use data rate of profile
+ * @param  *l: Pointer to @ref LINK_t structure
+ * @param  profile: Initial profile, LINK_PROFILES - 1 is most robust
+ * @retval None
+ */
+void LINK_Init(LINK_t* l, uint8_t profile);
+
+/**
+ * @brief  Measures link and changes profile, call from main loop
+ * @param  *l: Pointer to @ref LINK_t structure
+ * @retval 1 when radio is reserved and no packet may be sent, 0 otherwise
+ */
+uint8_t LINK_Process(LINK_t* l);
+
+/**
+ * @brief  Packs announcement of new data rate when it should be sent
+ * @note   Layout: 'R', new data rate, new output power, profile, 6 bytes zero. Packet must be
+ *         sent with @ref NRF24L01_Send() right after this function returns 1
+ * @param  *l: Pointer to @ref LINK_t structure
+ * @param  *data: Pointer to 10 bytes output buffer
+ * @retval 1 if announcement was packed, 0 otherwise
+ */
+uint8_t LINK_GetAnnounce(LINK_t* l, uint8_t* data);
+
+/**
+ * @brief  Gets link statistics once per LINK_SUMMARY_MS
+ * @param  *l: Pointer to @ref LINK_t structure
+ * @param  *s: Pointer to @ref LINK_Summary_t structure to store statistics to
+ * @retval 1 if new summary is available, 0 otherwise
+ */
+uint8_t LINK_GetSummary(LINK_t* l, LINK_Summary_t* s);
+
+/**
+ * @brief  Packs statistics to 10 bytes for transmission
+ * @note   Layout: 'L', profile, loss in permille (LE), retransmissions x100 (LE),
+ *         energy per packet in nC (LE, 16 bits, saturated), profile changes (LE)
+ * @param  *s: Pointer to @ref LINK_Summary_t structure
+ * @param  *data: Pointer to 10 bytes output buffer
+ * @retval None
+ */
+void LINK_Pack(const LINK_Summary_t* s, uint8_t* data);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
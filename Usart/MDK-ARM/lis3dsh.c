@@ -0,0 +1,184 @@
+#include "lis3dsh.h"
+#include "exti.h"
+
+/* SPI read bit */
+#define LIS3DSH_READ_MASK(reg)			(0x80 | (reg))
+
+/* CTRL_REG4 axes enable and block data update */
+#define LIS3DSH_CTRL_REG4_XYZ			0x07
+#define LIS3DSH_CTRL_REG4_BDU			0x08
+
+/* CTRL_REG3 data ready on INT1, active high, pulsed */
+#define LIS3DSH_CTRL_REG3_DR_EN			0x80
+#define LIS3DSH_CTRL_REG3_IEA			0x40
+#define LIS3DSH_CTRL_REG3_IEL			0x20
+#define LIS3DSH_CTRL_REG3_INT1_EN		0x08
+
+/* CTRL_REG6 bits */
+#define LIS3DSH_CTRL_REG6_FIFO_EN		0x40
+#define LIS3DSH_CTRL_REG6_ADD_INC		0x10
+
+/* FIFO_CTRL stream mode */
+#define LIS3DSH_FIFO_MODE_STREAM		0x40
+
+/* FIFO_SRC bits */
+#define LIS3DSH_FIFO_SRC_OVRN			0x40
+#define LIS3DSH_FIFO_SRC_EMPTY			0x20
+#define LIS3DSH_FIFO_SRC_FSS			0x1F
+
+/* Sensitivity in g/digit for each scale */
+static const float LIS3DSH_Sensitivity[] = {
+	0.00006f, 0.00012f, 0.00018f, 0.00024f, 0.00073f
+};
+
+static LIS3DSH_Scale_t LIS3DSH_CurrentScale = LIS3DSH_Scale_2G;
+
+/* Written only in interrupt (head) and main loop (tail) */
+static LIS3DSH_Axes_t LIS3DSH_Buffer[LIS3DSH_BUFFER_SIZE];
+static volatile uint16_t LIS3DSH_Head, LIS3DSH_Tail;
+
+LIS3DSH_Result_t LIS3DSH_Init(LIS3DSH_ODR_t odr, LIS3DSH_Scale_t scale) {
+	/* Sensor needs clock idle high, data latched on rising edge */
+	LIS3DSH_SPI->CR1 &= ~SPI_CR1_SPE;
+	LIS3DSH_SPI->CR1 |= SPI_CR1_CPOL | SPI_CR1_CPHA;
+	LIS3DSH_SPI->CR1 |= SPI_CR1_SPE;
+	LIS3DSH_CS_HIGH;
+
+	if (LIS3DSH_ReadRegister(LIS3DSH_REG_WHO_AM_I) != LIS3DSH_ID) {
+		return LIS3DSH_Result_Error;
+	}
+
+	LIS3DSH_CurrentScale = scale;
+	LIS3DSH_WriteRegister(LIS3DSH_REG_CTRL_REG4, (uint8_t)(odr << 4) | LIS3DSH_CTRL_REG4_BDU | LIS3DSH_CTRL_REG4_XYZ);
+	LIS3DSH_WriteRegister(LIS3DSH_REG_CTRL_REG5, (uint8_t)(scale << 3));
+
+	/* Stream mode keeps last 32 samples, reading frees them */
+	LIS3DSH_WriteRegister(LIS3DSH_REG_CTRL_REG6, LIS3DSH_CTRL_REG6_FIFO_EN | LIS3DSH_CTRL_REG6_ADD_INC);
+	LIS3DSH_WriteRegister(LIS3DSH_REG_FIFO_CTRL, LIS3DSH_FIFO_MODE_STREAM);
+
+	return LIS3DSH_Result_Ok;
+}
+
+float LIS3DSH_GetSensitivity(void) {
+	return LIS3DSH_Sensitivity[LIS3DSH_CurrentScale];
+}
+
+void LIS3DSH_ReadAxes(LIS3DSH_Axes_t* axes) {
+	uint8_t data[6];
+
+	LIS3DSH_CS_LOW;
+	SPI_Send(LIS3DSH_SPI, LIS3DSH_READ_MASK(LIS3DSH_REG_OUT_X_L));
+	SPI_ReadMulti(LIS3DSH_SPI, data, 0x00, 6);
+	LIS3DSH_CS_HIGH;
+
+	axes->X = (int16_t)(data[1] << 8 | data[0]);
+	axes->Y = (int16_t)(data[3] << 8 | data[2]);
+	axes->Z = (int16_t)(data[5] << 8 | data[4]);
+}
+
+uint8_t LIS3DSH_ReadFifo(LIS3DSH_Axes_t* axes, uint8_t max) {
+	uint8_t src = LIS3DSH_ReadRegister(LIS3DSH_REG_FIFO_SRC);
+	uint8_t count;
+
+	if (src & LIS3DSH_FIFO_SRC_EMPTY) {
+		return 0;
+	}
+
+	/* FSS does not count the 32nd sample, overrun means FIFO is full */
+	count = (src & LIS3DSH_FIFO_SRC_OVRN) ? LIS3DSH_FIFO_SIZE : (src & LIS3DSH_FIFO_SRC_FSS);
+	if (count > max) {
+		count = max;
+	}
+
+	/* With FIFO and ADD_INC address rolls back from OUT_Z_H to OUT_X_L, whole FIFO is one burst.
+	   Bytes are little endian X, Y, Z, same as layout of LIS3DSH_Axes_t */
+	LIS3DSH_CS_LOW;
+	SPI_Send(LIS3DSH_SPI, LIS3DSH_READ_MASK(LIS3DSH_REG_OUT_X_L));
+	SPI_ReadMulti(LIS3DSH_SPI, (uint8_t *)axes, 0x00, (uint32_t)count * sizeof(LIS3DSH_Axes_t));
+	LIS3DSH_CS_HIGH;
+
+	return count;
+}
+
+LIS3DSH_Result_t LIS3DSH_EnableInterrupt(void) {
+	/* Line 0 is used as event by user button in CubeMX configuration */
+	EXTI_Detach(LIS3DSH_INT1_PIN);
+	if (EXTI_Attach(LIS3DSH_INT1_PORT, LIS3DSH_INT1_PIN, EXTI_Trigger_Rising) != EXTI_Result_Ok) {
+		return LIS3DSH_Result_Error;
+	}
+	EXTI_SetPriority(LIS3DSH_INT1_PIN, LIS3DSH_NVIC_PRIORITY, 0);
+
+	/* Interrupt must not break into SPI burst of initial drain, edge raised meanwhile stays pending */
+	NVIC_DisableIRQ(LIS3DSH_INT1_CHANNEL);
+
+	/* Drop samples collected so far, interrupt starts with empty FIFO */
+	LIS3DSH_Head = LIS3DSH_Tail = 0;
+	LIS3DSH_WriteRegister(LIS3DSH_REG_CTRL_REG3, LIS3DSH_CTRL_REG3_DR_EN | LIS3DSH_CTRL_REG3_IEA | LIS3DSH_CTRL_REG3_IEL | LIS3DSH_CTRL_REG3_INT1_EN);
+	LIS3DSH_IRQHandler();
+
+	NVIC_EnableIRQ(LIS3DSH_INT1_CHANNEL);
+
+	return LIS3DSH_Result_Ok;
+}
+
+void LIS3DSH_IRQHandler(void) {
+	LIS3DSH_Axes_t axes[LIS3DSH_FIFO_SIZE];
+	uint16_t head;
+	uint8_t count, i;
+
+	count = LIS3DSH_ReadFifo(axes, LIS3DSH_FIFO_SIZE);
+	if (count == 0) {
+		return;
+	}
+
+	/* Newest samples are dropped when main loop does not keep up */
+	head = LIS3DSH_Head;
+	for (i = 0; i < count; i++) {
+		if ((uint16_t)(head - LIS3DSH_Tail) >= LIS3DSH_BUFFER_SIZE) {
+			break;
+		}
+		LIS3DSH_Buffer[head & (LIS3DSH_BUFFER_SIZE - 1)] = axes[i];
+		head++;
+	}
+	LIS3DSH_Head = head;
+
+	LIS3DSH_SamplesCallback(axes, count);
+}
+
+uint8_t LIS3DSH_ReadBuffer(LIS3DSH_Axes_t* axes, uint8_t max) {
+	uint16_t tail = LIS3DSH_Tail;
+	uint8_t count = 0;
+
+	while (tail != LIS3DSH_Head && count < max) {
+		axes[count++] = LIS3DSH_Buffer[tail & (LIS3DSH_BUFFER_SIZE - 1)];
+		tail++;
+	}
+	/* Only main loop writes tail after interrupt is enabled, interrupt just reads it */
+	LIS3DSH_Tail = tail;
+
+	return count;
+}
+
+__weak void LIS3DSH_SamplesCallback(const LIS3DSH_Axes_t* axes, uint8_t count) {
+	/* NOTE : This function Should not be modified, when the callback is needed,
+	          the LIS3DSH_SamplesCallback could be implemented in the user file
+	 */
+}
+
+uint8_t LIS3DSH_ReadRegister(uint8_t reg) {
+	uint8_t value;
+
+	LIS3DSH_CS_LOW;
+	SPI_Send(LIS3DSH_SPI, LIS3DSH_READ_MASK(reg));
+	value = SPI_Send(LIS3DSH_SPI, 0x00);
+	LIS3DSH_CS_HIGH;
+
+	return value;
+}
+
+void LIS3DSH_WriteRegister(uint8_t reg, uint8_t value) {
+	LIS3DSH_CS_LOW;
+	SPI_Send(LIS3DSH_SPI, reg);
+	SPI_Send(LIS3DSH_SPI, value);
+	LIS3DSH_CS_HIGH;
+}
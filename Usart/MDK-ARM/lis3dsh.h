@@ -0,0 +1,185 @@
+#ifndef LIS3DSH_H
+#define LIS3DSH_H 100
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * LIS3DSH accelerometer on STM32F4-Discovery, connected to SPI1
+ *
+ * SPI1:  PA5 (SCK), PA6 (MISO), PA7 (MOSI)
+ * CS:    PE3
+ * INT1:  PE0
+ * INT2:  PE1
+ *
+ * SPI1 peripheral and CS pin are configured by CubeMX code,
+ * driver only switches SPI1 to mode 3 required by sensor.
+ */
+
+#include "stm32f4xx_hal.h"
+#include "spi.h"
+
+/* Default SPI used */
+#ifndef LIS3DSH_SPI
+#define LIS3DSH_SPI					SPI1
+#endif
+
+/* SPI chip select pin */
+#ifndef LIS3DSH_CS_PIN
+#define LIS3DSH_CS_PORT				GPIOE
+#define LIS3DSH_CS_PIN				GPIO_PIN_3  // PE3 (CS)
+#endif
+
+/* Data ready interrupt pin, INT1 */
+#ifndef LIS3DSH_INT1_PIN
+#define LIS3DSH_INT1_PORT			GPIOE
+#define LIS3DSH_INT1_PIN			GPIO_PIN_0  // PE0 (INT1)
+#define LIS3DSH_INT1_CHANNEL		EXTI0_IRQn
+#endif
+
+/* Preemption priority of data ready interrupt, samples are read in interrupt */
+#ifndef LIS3DSH_NVIC_PRIORITY
+#define LIS3DSH_NVIC_PRIORITY		0x00
+#endif
+
+/* Software buffer between interrupt and main loop, power of 2 */
+#define LIS3DSH_BUFFER_SIZE			64
+
+/* Pins configuration */
+#define LIS3DSH_CS_LOW				GPIO_SetPinLow(LIS3DSH_CS_PORT, LIS3DSH_CS_PIN)
+#define LIS3DSH_CS_HIGH				GPIO_SetPinHigh(LIS3DSH_CS_PORT, LIS3DSH_CS_PIN)
+
+/* Registers */
+#define LIS3DSH_REG_WHO_AM_I		0x0F
+#define LIS3DSH_REG_CTRL_REG4		0x20
+#define LIS3DSH_REG_CTRL_REG3		0x23
+#define LIS3DSH_REG_CTRL_REG5		0x24
+#define LIS3DSH_REG_CTRL_REG6		0x25
+#define LIS3DSH_REG_STATUS			0x27
+#define LIS3DSH_REG_OUT_X_L			0x28
+#define LIS3DSH_REG_FIFO_CTRL		0x2E
+#define LIS3DSH_REG_FIFO_SRC		0x2F
+
+/* WHO_AM_I value */
+#define LIS3DSH_ID					0x3F
+
+/* FIFO depth in samples */
+#define LIS3DSH_FIFO_SIZE			32
+
+typedef enum {
+	LIS3DSH_Result_Ok = 0x00, /*!< Everything OK */
+	LIS3DSH_Result_Error      /*!< Device is not connected or has wrong ID */
+} LIS3DSH_Result_t;
+
+typedef enum {
+	LIS3DSH_ODR_3_125Hz = 0x01, /*!< Output data rate 3.125 Hz */
+	LIS3DSH_ODR_6_25Hz,         /*!< Output data rate 6.25 Hz */
+	LIS3DSH_ODR_12_5Hz,         /*!< Output data rate 12.5 Hz */
+	LIS3DSH_ODR_25Hz,           /*!< Output data rate 25 Hz */
+	LIS3DSH_ODR_50Hz,           /*!< Output data rate 50 Hz */
+	LIS3DSH_ODR_100Hz,          /*!< Output data rate 100 Hz */
+	LIS3DSH_ODR_400Hz,          /*!< Output data rate 400 Hz */
+	LIS3DSH_ODR_800Hz,          /*!< Output data rate 800 Hz */
+	LIS3DSH_ODR_1600Hz          /*!< Output data rate 1600 Hz */
+} LIS3DSH_ODR_t;
+
+typedef enum {
+	LIS3DSH_Scale_2G = 0x00, /*!< Full scale +-2g, 0.06 mg/digit */
+	LIS3DSH_Scale_4G,        /*!< Full scale +-4g, 0.12 mg/digit */
+	LIS3DSH_Scale_6G,        /*!< Full scale +-6g, 0.18 mg/digit */
+	LIS3DSH_Scale_8G,        /*!< Full scale +-8g, 0.24 mg/digit */
+	LIS3DSH_Scale_16G        /*!< Full scale +-16g, 0.73 mg/digit */
+} LIS3DSH_Scale_t;
+
+typedef struct {
+	int16_t X; /*!< X axis raw value */
+	int16_t Y; /*!< Y axis raw value */
+	int16_t Z; /*!< Z axis raw value */
+} LIS3DSH_Axes_t;
+
+/**
+ * @brief  Initializes LIS3DSH with all axes enabled and FIFO in stream mode
+ * @param  odr: Output data rate. This parameter can be a value of @ref LIS3DSH_ODR_t enumeration
+ * @param  scale: Full scale. This parameter can be a value of @ref LIS3DSH_Scale_t enumeration
+ * @retval Member of @ref LIS3DSH_Result_t enumeration
+ */
+LIS3DSH_Result_t LIS3DSH_Init(LIS3DSH_ODR_t odr, LIS3DSH_Scale_t scale);
+
+/**
+ * @brief  Gets sensitivity for selected scale
+ * @param  None
+ * @retval Value of one digit in g units
+ */
+float LIS3DSH_GetSensitivity(void);
+
+/**
+ * @brief  Reads latest sample of all axes
+ * @param  *axes: Pointer to @ref LIS3DSH_Axes_t where values are saved
+ * @retval None
+ */
+void LIS3DSH_ReadAxes(LIS3DSH_Axes_t* axes);
+
+/**
+ * @brief  Reads all samples stored in FIFO, oldest first, in one SPI burst
+ * @param  *axes: Pointer to array of @ref LIS3DSH_Axes_t
+ * @param  max: Maximal number of samples to read
+ * @retval Number of samples read
+ */
+uint8_t LIS3DSH_ReadFifo(LIS3DSH_Axes_t* axes, uint8_t max);
+
+/**
+ * @brief  Moves sensor reading to data ready interrupt on INT1
+ * @note   After this call sensor is accessed only from interrupt, use @ref LIS3DSH_ReadBuffer()
+ *         instead of @ref LIS3DSH_ReadFifo(). Line 0 event of user button is detached.
+ * @param  None
+ * @retval Member of @ref LIS3DSH_Result_t enumeration
+ */
+LIS3DSH_Result_t LIS3DSH_EnableInterrupt(void);
+
+/**
+ * @brief  Reads samples from FIFO to software buffer, call from EXTI_Handler() for INT1 line
+ * @param  None
+ * @retval None
+ */
+void LIS3DSH_IRQHandler(void);
+
+/**
+ * @brief  Reads samples collected in interrupt, oldest first
+ * @param  *axes: Pointer to array of @ref LIS3DSH_Axes_t
+ * @param  max: Maximal number of samples to read
+ * @retval Number of samples read
+ */
+uint8_t LIS3DSH_ReadBuffer(LIS3DSH_Axes_t* axes, uint8_t max);
+
+/**
+ * @brief  Called from interrupt with new samples, for low latency processing
+ * @note   With __weak parameter to prevent link errors if not defined by user
+ * @param  *axes: Pointer to new samples, oldest first
+ * @param  count: Number of samples
+ * @retval None
+ */
+void LIS3DSH_SamplesCallback(const LIS3DSH_Axes_t* axes, uint8_t count);
+
+/**
+ * @brief  Reads single register
+ * @param  reg: Register address
+ * @retval Register value
+ */
+uint8_t LIS3DSH_ReadRegister(uint8_t reg);
+
+/**
+ * @brief  Writes single register
+ * @param  reg: Register address
+ * @param  value: Value to write
+ * @retval None
+ */
+void LIS3DSH_WriteRegister(uint8_t reg, uint8_t value);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,148 @@
+#include "median.h"
+
+/* Number of items in min-heap and max-heap */
+#define MEDIAN_MIN_COUNT(m)			(((int32_t)(m)->Count - 1) / 2)
+#define MEDIAN_MAX_COUNT(m)			((int32_t)(m)->Count / 2)
+
+/* Private functions */
+static uint8_t MEDIAN_Less(MEDIAN_t* m, int32_t i, int32_t j);
+static uint8_t MEDIAN_CmpExchange(MEDIAN_t* m, int32_t i, int32_t j);
+static void MEDIAN_MinSortDown(MEDIAN_t* m, int32_t i);
+static void MEDIAN_MaxSortDown(MEDIAN_t* m, int32_t i);
+static uint8_t MEDIAN_MinSortUp(MEDIAN_t* m, int32_t i);
+static uint8_t MEDIAN_MaxSortUp(MEDIAN_t* m, int32_t i);
+
+void MEDIAN_Init(MEDIAN_t* m, uint16_t size, q15_t* data, int16_t* pos, int16_t* heap) {
+	int32_t n = size;
+
+	m->Data = data;
+	m->Pos = pos;
+	m->Heap = heap + size / 2;
+	m->Size = size;
+	m->Idx = 0;
+	m->Count = 0;
+
+	/* Alternate ring buffer items between max-heap and min-heap: 0, -1, 1, -2, 2 ... */
+	while (n-- > 0) {
+		m->Pos[n] = (int16_t)(((n + 1) / 2) * ((n & 1) ? -1 : 1));
+		m->Heap[m->Pos[n]] = (int16_t)n;
+		m->Data[n] = 0;
+	}
+}
+
+q15_t MEDIAN_Insert(MEDIAN_t* m, q15_t value) {
+	uint8_t isNew = m->Count < m->Size;
+	int32_t p = m->Pos[m->Idx];
+	q15_t old = m->Data[m->Idx];
+
+	/* Replace oldest sample */
+	m->Data[m->Idx] = value;
+	if (++m->Idx == m->Size) {
+		m->Idx = 0;
+	}
+	m->Count += isNew;
+
+	if (p > 0) {
+		/* Item is in min-heap */
+		if (!isNew && old < value) {
+			MEDIAN_MinSortDown(m, p * 2);
+		} else if (MEDIAN_MinSortUp(m, p)) {
+			MEDIAN_MaxSortDown(m, -1);
+		}
+	} else if (p < 0) {
+		/* Item is in max-heap */
+		if (!isNew && value < old) {
+			MEDIAN_MaxSortDown(m, p * 2);
+		} else if (MEDIAN_MaxSortUp(m, p)) {
+			MEDIAN_MinSortDown(m, 1);
+		}
+	} else {
+		/* Item is median */
+		if (MEDIAN_MAX_COUNT(m)) {
+			MEDIAN_MaxSortDown(m, -1);
+		}
+		if (MEDIAN_MIN_COUNT(m)) {
+			MEDIAN_MinSortDown(m, 1);
+		}
+	}
+
+	return MEDIAN_Get(m);
+}
+
+q15_t MEDIAN_Get(MEDIAN_t* m) {
+	q15_t v = m->Data[m->Heap[0]];
+
+	if ((m->Count & 1) == 0 && m->Count > 0) {
+		v = (q15_t)((v + m->Data[m->Heap[-1]]) >> 1);
+	}
+	return v;
+}
+
+void MEDIAN_Process_q15(MEDIAN_t* m, const q15_t* src, q15_t* dst, uint32_t count) {
+	while (count-- > 0) {
+		*dst++ = MEDIAN_Insert(m, *src++);
+	}
+}
+
+static uint8_t MEDIAN_Less(MEDIAN_t* m, int32_t i, int32_t j) {
+	return m->Data[m->Heap[i]] < m->Data[m->Heap[j]];
+}
+
+/* Swaps heap items if item i is less than item j */
+static uint8_t MEDIAN_CmpExchange(MEDIAN_t* m, int32_t i, int32_t j) {
+	int16_t t;
+
+	if (!MEDIAN_Less(m, i, j)) {
+		return 0;
+	}
+	t = m->Heap[i];
+	m->Heap[i] = m->Heap[j];
+	m->Heap[j] = t;
+	m->Pos[m->Heap[i]] = (int16_t)i;
+	m->Pos[m->Heap[j]] = (int16_t)j;
+	return 1;
+}
+
+/* Restores min-heap from item i down, i is child index of item which was changed */
+static void MEDIAN_MinSortDown(MEDIAN_t* m, int32_t i) {
+	int32_t cnt = MEDIAN_MIN_COUNT(m);
+
+	for (; i <= cnt; i *= 2) {
+		if (i > 1 && i < cnt && MEDIAN_Less(m, i + 1, i)) {
+			i++;
+		}
+		if (!MEDIAN_CmpExchange(m, i, i / 2)) {
+			break;
+		}
+	}
+}
+
+/* Restores max-heap from item i down, indexes are negative */
+static void MEDIAN_MaxSortDown(MEDIAN_t* m, int32_t i) {
+	int32_t cnt = -MEDIAN_MAX_COUNT(m);
+
+	for (; i >= cnt; i *= 2) {
+		if (i < -1 && i > cnt && MEDIAN_Less(m, i, i - 1)) {
+			i--;
+		}
+		if (!MEDIAN_CmpExchange(m, i / 2, i)) {
+			break;
+		}
+	}
+}
+
+/* Moves item up in min-heap, returns 1 if it reached median position */
+static uint8_t MEDIAN_MinSortUp(MEDIAN_t* m, int32_t i) {
+	while (i > 0 && MEDIAN_CmpExchange(m, i, i / 2)) {
+		i /= 2;
+	}
+	return i == 0;
+}
+
+/* Moves item up in max-heap, returns 1 if it reached median position */
+static uint8_t MEDIAN_MaxSortUp(MEDIAN_t* m, int32_t i) {
+	while (i < 0 && MEDIAN_CmpExchange(m, i / 2, i)) {
+		i /= 2;
+	}
+	return i == 0;
+}
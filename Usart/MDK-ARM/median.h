@@ -0,0 +1,78 @@
+#ifndef MEDIAN_H
+#define MEDIAN_H 100
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Sliding window median filter for q15 samples.
+ *
+ * Window is kept in ring buffer, items are indexed by max-heap (lower half) and
+ * min-heap (upper half) sharing one array with median in the middle.
+ * Each new sample replaces the oldest one and costs O(log n) compares.
+ *
+ * All memory is provided by user, for window size N:
+ *  - q15_t data[N]
+ *  - int16_t pos[N]
+ *  - int16_t heap[N]
+ */
+
+#include "stm32f4xx_hal.h"
+#include "arm_math.h"
+
+/* Maximal window size, limited by 16-bit heap indexes */
+#define MEDIAN_MAX_SIZE				32767
+
+typedef struct {
+	q15_t* Data;    /*!< Ring buffer with window samples */
+	int16_t* Pos;   /*!< Heap index of each ring buffer item */
+	int16_t* Heap;  /*!< Points to the middle of heap array, max-heap is at negative indexes, min-heap at positive */
+	uint16_t Size;  /*!< Window size */
+	uint16_t Idx;   /*!< Ring buffer position of oldest sample */
+	uint16_t Count; /*!< Number of samples in window, grows to Size after start */
+} MEDIAN_t;
+
+/**
+ * @brief  Initializes median filter
+ * @param  *m: Pointer to @ref MEDIAN_t structure
+ * @param  size: Window size, odd value gives true median, from 1 to @ref MEDIAN_MAX_SIZE
+ * @param  *data: Pointer to buffer with size elements for samples
+ * @param  *pos: Pointer to buffer with size elements for positions
+ * @param  *heap: Pointer to buffer with size elements for heap
+ * @retval None
+ */
+void MEDIAN_Init(MEDIAN_t* m, uint16_t size, q15_t* data, int16_t* pos, int16_t* heap);
+
+/**
+ * @brief  Adds new sample to window, oldest one is removed when window is full
+ * @param  *m: Pointer to @ref MEDIAN_t structure
+ * @param  value: New sample
+ * @retval Median of current window
+ */
+q15_t MEDIAN_Insert(MEDIAN_t* m, q15_t value);
+
+/**
+ * @brief  Gets median of current window without adding sample
+ * @param  *m: Pointer to @ref MEDIAN_t structure
+ * @retval Median of current window, average of middle two for even count
+ */
+q15_t MEDIAN_Get(MEDIAN_t* m);
+
+/**
+ * @brief  Filters block of samples
+ * @param  *m: Pointer to @ref MEDIAN_t structure
+ * @param  *src: Pointer to input samples
+ * @param  *dst: Pointer to output samples, can be the same as src
+ * @param  count: Number of samples
+ * @retval None
+ */
+void MEDIAN_Process_q15(MEDIAN_t* m, const q15_t* src, q15_t* dst, uint32_t count);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
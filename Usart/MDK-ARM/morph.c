@@ -0,0 +1,65 @@
+#include "morph.h"
+
+void MORPH_Init(MORPH_Window_t* w, uint16_t size, MORPH_Type_t type, q15_t* values, uint16_t* stamps) {
+	w->Values = values;
+	w->Stamps = stamps;
+	w->Size = size;
+	w->Head = 0;
+	w->Count = 0;
+	w->Time = 0;
+	w->Type = type;
+}
+
+q15_t MORPH_Push(MORPH_Window_t* w, q15_t value) {
+	uint16_t tail;
+
+	/* Drop values from tail which can never be the result again */
+	while (w->Count) {
+		tail = w->Head + w->Count - 1;
+		if (tail >= w->Size) {
+			tail -= w->Size;
+		}
+		if (w->Type == MORPH_Type_Erode ? (w->Values[tail] < value) : (w->Values[tail] > value)) {
+			break;
+		}
+		w->Count--;
+	}
+
+	/* Drop head if it left the window, one at most as only one sample is added */
+	if (w->Count && (uint16_t)(w->Time - w->Stamps[w->Head]) >= w->Size) {
+		if (++w->Head == w->Size) {
+			w->Head = 0;
+		}
+		w->Count--;
+	}
+
+	/* Add to tail */
+	tail = w->Head + w->Count;
+	if (tail >= w->Size) {
+		tail -= w->Size;
+	}
+	w->Values[tail] = value;
+	w->Stamps[tail] = w->Time;
+	w->Count++;
+	w->Time++;
+
+	return w->Values[w->Head];
+}
+
+void MORPH_Process_q15(MORPH_Window_t* w, const q15_t* src, q15_t* dst, uint32_t count) {
+	while (count-- > 0) {
+		*dst++ = MORPH_Push(w, *src++);
+	}
+}
+
+void MORPH_Open_q15(MORPH_Window_t* erode, MORPH_Window_t* dilate, const q15_t* src, q15_t* dst, uint32_t count) {
+	while (count-- > 0) {
+		*dst++ = MORPH_Push(dilate, MORPH_Push(erode, *src++));
+	}
+}
+
+void MORPH_Close_q15(MORPH_Window_t* dilate, MORPH_Window_t* erode, const q15_t* src, q15_t* dst, uint32_t count) {
+	while (count-- > 0) {
+		*dst++ = MORPH_Push(erode, MORPH_Push(dilate, *src++));
+	}
+}
@@ -0,0 +1,95 @@
+#ifndef MORPH_H
+#define MORPH_H 100
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Sliding window minimum/maximum (erosion/dilation with flat structuring element)
+ * for q15 samples, based on monotonic deque. Each sample costs amortized O(1).
+ *
+ * Opening and closing are cascades of two windows, output is delayed by (size - 1) samples
+ * of each window.
+ *
+ * All memory is provided by user, for window size N:
+ *  - q15_t values[N]
+ *  - uint16_t stamps[N]
+ */
+
+#include "stm32f4xx_hal.h"
+#include "arm_math.h"
+
+typedef enum {
+	MORPH_Type_Erode = 0x00, /*!< Sliding minimum */
+	MORPH_Type_Dilate        /*!< Sliding maximum */
+} MORPH_Type_t;
+
+typedef struct {
+	q15_t* Values;      /*!< Deque values, monotonic from head to tail */
+	uint16_t* Stamps;   /*!< Sample counter of each deque value */
+	uint16_t Size;      /*!< Window size */
+	uint16_t Head;      /*!< Deque head position */
+	uint16_t Count;     /*!< Number of items in deque */
+	uint16_t Time;      /*!< Sample counter, wraps around */
+	MORPH_Type_t Type;  /*!< Window type */
+} MORPH_Window_t;
+
+/**
+ * @brief  Initializes sliding window
+ * @param  *w: Pointer to @ref MORPH_Window_t structure
+ * @param  size: Window size, from 1 to 65535
+ * @param  type: Window type. This parameter can be a value of @ref MORPH_Type_t enumeration
+ * @param  *values: Pointer to buffer with size elements
+ * @param  *stamps: Pointer to buffer with size elements
+ * @retval None
+ */
+void MORPH_Init(MORPH_Window_t* w, uint16_t size, MORPH_Type_t type, q15_t* values, uint16_t* stamps);
+
+/**
+ * @brief  Adds sample to window
+ * @param  *w: Pointer to @ref MORPH_Window_t structure
+ * @param  value: New sample
+ * @retval Minimum or maximum of last size samples
+ */
+q15_t MORPH_Push(MORPH_Window_t* w, q15_t value);
+
+/**
+ * @brief  Processes block of samples with one window
+ * @param  *w: Pointer to @ref MORPH_Window_t structure
+ * @param  *src: Pointer to input samples
+ * @param  *dst: Pointer to output samples, can be the same as src
+ * @param  count: Number of samples
+ * @retval None
+ */
+void MORPH_Process_q15(MORPH_Window_t* w, const q15_t* src, q15_t* dst, uint32_t count);
+
+/**
+ * @brief  Morphological opening (erosion followed by dilation), removes peaks narrower than window
+ * @param  *erode: Pointer to @ref MORPH_Window_t initialized as @ref MORPH_Type_Erode
+ * @param  *dilate: Pointer to @ref MORPH_Window_t initialized as @ref MORPH_Type_Dilate
+ * @param  *src: Pointer to input samples
+ * @param  *dst: Pointer to output samples, can be the same as src
+ * @param  count: Number of samples
+ * @retval None
+ */
+void MORPH_Open_q15(MORPH_Window_t* erode, MORPH_Window_t* dilate, const q15_t* src, q15_t* dst, uint32_t count);
+
+/**
+ * @brief  Morphological closing (dilation followed by erosion), removes pits narrower than window
+ * @param  *dilate: Pointer to @ref MORPH_Window_t initialized as @ref MORPH_Type_Dilate
+ * @param  *erode: Pointer to @ref MORPH_Window_t initialized as @ref MORPH_Type_Erode
+ * @param  *src: Pointer to input samples
+ * @param  *dst: Pointer to output samples, can be the same as src
+ * @param  count: Number of samples
+ * @retval None
+ */
+void MORPH_Close_q15(MORPH_Window_t* dilate, MORPH_Window_t* erode, const q15_t* src, q15_t* dst, uint32_t count);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,162 @@
+#include "nn.h"
+
+static void NN_Dense(const NN_Layer_t* l, q7_t* in, q7_t* out);
+static void NN_Conv1d(const NN_Layer_t* l, q7_t* in, q7_t* out);
+static void NN_MaxPool1d(const NN_Layer_t* l, const q7_t* in, q7_t* out);
+
+/*
+ * Dot product in 18.14, tail is summed here. CMSIS tail passes sign-extended q7 to __SMLAD,
+ * which also multiplies upper halfwords and adds 1 for every pair of negative samples.
+ */
+static __INLINE q31_t NN_Dot(q7_t* a, q7_t* b, uint32_t n) {
+	uint32_t m = n & ~3UL;
+	q31_t acc;
+
+	arm_dot_prod_q7(a, b, m, &acc);
+	for (; m < n; m++) {
+		acc += (q31_t)a[m] * b[m];
+	}
+	return acc;
+}
+
+/* Bias, rounding, shift, saturation and activation of one accumulator */
+static __INLINE q7_t NN_Output(const NN_Layer_t* l, q31_t acc, uint16_t ch) {
+	acc += (q31_t)l->Bias[ch] << l->BiasShift;
+	if (l->OutShift) {
+		acc = (acc + (1 << (l->OutShift - 1))) >> l->OutShift;
+	}
+	acc = __SSAT(acc, 8);
+	if (l->Activation == NN_Activation_Relu && acc < 0) {
+		acc = 0;
+	}
+	return (q7_t)acc;
+}
+
+NN_Result_t NN_Init(NN_t* nn, const NN_Model_t* model, q7_t* arena, uint32_t arenaSize) {
+	uint32_t half = (model->MaxTensor + 3) & ~3UL;
+	uint32_t size = model->InputSize;
+	const NN_Layer_t* l;
+	uint16_t i;
+
+	if (model->Magic != NN_MAGIC || model->NumLayers == 0 || model->NumLayers > NN_MAX_LAYERS ||
+		model->InputSize > model->MaxTensor || arenaSize < 2 * half) {
+		return NN_Result_Error;
+	}
+
+	/* Each layer must consume output of previous one and fit arena */
+	for (i = 0; i < model->NumLayers; i++) {
+		l = &model->Layers[i];
+		if ((uint32_t)l->InLen * l->InCh != size || (uint32_t)l->OutLen * l->OutCh > model->MaxTensor) {
+			return NN_Result_Error;
+		}
+		if (l->Type == NN_Layer_Dense && (l->InCh != 1 || l->OutCh != 1)) {
+			return NN_Result_Error;
+		}
+		if (l->Type == NN_Layer_Conv1d && (l->Stride == 0 || l->Kernel > l->InLen || l->OutLen != (l->InLen - l->Kernel) / l->Stride + 1)) {
+			return NN_Result_Error;
+		}
+		if (l->Type == NN_Layer_MaxPool1d && (l->Kernel == 0 || l->OutCh != l->InCh || l->OutLen != l->InLen / l->Kernel)) {
+			return NN_Result_Error;
+		}
+		size = (uint32_t)l->OutLen * l->OutCh;
+	}
+
+	nn->Model = model;
+	nn->Buffer[0] = arena;
+	nn->Buffer[1] = arena + half;
+	memset(nn->Cycles, 0, sizeof(nn->Cycles));
+	nn->Total = 0;
+
+	return NN_Result_Ok;
+}
+
+const q7_t* NN_Run(NN_t* nn, const q7_t* input) {
+	const NN_Model_t* model = nn->Model;
+	const NN_Layer_t* l;
+	uint32_t start, stamp;
+	uint8_t cur = 0;
+	uint16_t i;
+
+	start = DWT->CYCCNT;
+	memcpy(nn->Buffer[0], input, model->InputSize);
+
+	for (i = 0; i < model->NumLayers; i++) {
+		l = &model->Layers[i];
+		stamp = DWT->CYCCNT;
+
+		switch (l->Type) {
+			case NN_Layer_Dense:
+				NN_Dense(l, nn->Buffer[cur], nn->Buffer[cur ^ 1]);
+				break;
+			case NN_Layer_Conv1d:
+				NN_Conv1d(l, nn->Buffer[cur], nn->Buffer[cur ^ 1]);
+				break;
+			default:
+				NN_MaxPool1d(l, nn->Buffer[cur], nn->Buffer[cur ^ 1]);
+				break;
+		}
+		cur ^= 1;
+
+		nn->Cycles[i] = DWT->CYCCNT - stamp;
+	}
+	nn->Total = DWT->CYCCNT - start;
+
+	return nn->Buffer[cur];
+}
+
+uint16_t NN_Argmax(const q7_t* x, uint16_t count) {
+	uint16_t i, best = 0;
+
+	for (i = 1; i < count; i++) {
+		if (x[i] > x[best]) {
+			best = i;
+		}
+	}
+	return best;
+}
+
+static void NN_Dense(const NN_Layer_t* l, q7_t* in, q7_t* out) {
+	q7_t* w = (q7_t *)l->Weights;
+	uint16_t o;
+
+	for (o = 0; o < l->OutLen; o++) {
+		out[o] = NN_Output(l, NN_Dot(in, w, l->InLen), o);
+		w += l->InLen;
+	}
+}
+
+static void NN_Conv1d(const NN_Layer_t* l, q7_t* in, q7_t* out) {
+	uint32_t window = (uint32_t)l->Kernel * l->InCh;
+	uint32_t step = (uint32_t)l->Stride * l->InCh;
+	q7_t* w;
+	uint16_t t, f;
+
+	/* Window over all input channels is contiguous, one dot product per output */
+	for (t = 0; t < l->OutLen; t++) {
+		w = (q7_t *)l->Weights;
+		for (f = 0; f < l->OutCh; f++) {
+			*out++ = NN_Output(l, NN_Dot(in, w, window), f);
+			w += window;
+		}
+		in += step;
+	}
+}
+
+static void NN_MaxPool1d(const NN_Layer_t* l, const q7_t* in, q7_t* out) {
+	uint16_t t, k, c;
+	q7_t max;
+
+	for (t = 0; t < l->OutLen; t++) {
+		for (c = 0; c < l->InCh; c++) {
+			max = in[c];
+			for (k = 1; k < l->Kernel; k++) {
+				if (in[k * l->InCh + c] > max) {
+					max = in[k * l->InCh + c];
+				}
+			}
+			out[c] = max;
+		}
+		in += l->Kernel * l->InCh;
+		out += l->InCh;
+	}
+}
@@ -0,0 +1,123 @@
+#ifndef NN_H
+#define NN_H 100
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Minimal q7 inference runtime for small dense and 1-D convolutional networks,
+ * for example activity or rhythm classification.
+ *
+ * Model is constant structure in flash, generated from trained network by Host/nn_convert.py:
+ *
+ *   static const q7_t conv1_w[] = { ... };
+ *   static const q7_t conv1_b[] = { ... };
+ *   static const NN_Layer_t layers[] = {
+ *       {NN_Layer_Conv1d, NN_Activation_Relu, 64, 3, 60, 8, 5, 1, 0, 7, conv1_w, conv1_b},
+ *       ...
+ *   };
+ *   const NN_Model_t model = {NN_MAGIC, sizeof(layers) / sizeof(layers[0]), 192, 480, layers};
+ *
+ * Tensors are q7 and interleaved by channel, x[t * channels + c], so convolution window
+ * over all input channels is contiguous. Weights are stored in the same order:
+ *  - dense:   w[out][in]
+ *  - conv 1d: w[filter][k][channel], valid padding
+ *
+ * Every output is one dot product to 18.14 accumulator, then
+ * out = sat8((acc + (bias << BiasShift)) >> OutShift).
+ * Host/nn_ref.py is bit-exact reference of this arithmetic, checked by "make test" in Host.
+ *
+ * Activations ping-pong between two halves of static arena provided by user,
+ * each half must hold NN_Model_t::MaxTensor elements.
+ */
+
+#include "stm32f4xx_hal.h"
+#include "arm_math.h"
+
+/* Model format identifier, "NN01" */
+#define NN_MAGIC					0x31304E4EUL
+
+/* Maximal number of layers with cycle counters */
+#define NN_MAX_LAYERS				16
+
+typedef enum {
+	NN_Result_Ok = 0x00,      /*!< Everything OK */
+	NN_Result_Error           /*!< Invalid model or arena too small */
+} NN_Result_t;
+
+typedef enum {
+	NN_Layer_Dense = 0x00,    /*!< Fully connected */
+	NN_Layer_Conv1d,          /*!< 1-D convolution */
+	NN_Layer_MaxPool1d        /*!< 1-D max pooling, stride equals kernel */
+} NN_LayerType_t;
+
+typedef enum {
+	NN_Activation_None = 0x00,
+	NN_Activation_Relu
+} NN_Activation_t;
+
+typedef struct {
+	uint8_t Type;             /*!< Member of @ref NN_LayerType_t enumeration */
+	uint8_t Activation;       /*!< Member of @ref NN_Activation_t enumeration */
+	uint16_t InLen;           /*!< Input length, features for dense layer */
+	uint16_t InCh;            /*!< Input channels, 1 for dense layer */
+	uint16_t OutLen;          /*!< Output length, features for dense layer */
+	uint16_t OutCh;           /*!< Output channels, 1 for dense layer */
+	uint16_t Kernel;          /*!< Kernel length, not used for dense layer */
+	uint16_t Stride;          /*!< Convolution stride */
+	uint8_t BiasShift;        /*!< Left shift of bias to accumulator format */
+	uint8_t OutShift;         /*!< Right shift of accumulator to output */
+	const q7_t* Weights;      /*!< Weights, NULL for pooling */
+	const q7_t* Bias;         /*!< Bias per output channel, NULL for pooling */
+} NN_Layer_t;
+
+typedef struct {
+	uint32_t Magic;           /*!< Must be @ref NN_MAGIC */
+	uint16_t NumLayers;       /*!< Number of layers */
+	uint16_t InputSize;       /*!< Number of input elements */
+	uint16_t MaxTensor;       /*!< Largest activation tensor in elements, input included */
+	const NN_Layer_t* Layers; /*!< Pointer to layers */
+} NN_Model_t;
+
+typedef struct {
+	const NN_Model_t* Model;  /*!< Pointer to model in flash */
+	q7_t* Buffer[2];          /*!< Arena halves */
+	uint32_t Cycles[NN_MAX_LAYERS]; /*!< Cycles of each layer in last run */
+	uint32_t Total;           /*!< Cycles of last run */
+} NN_t;
+
+/**
+ * @brief  Checks model and assigns arena
+ * @note   DWT cycle counter must be running for cycle counts, for example by PROF_Init()
+ * @param  *nn: Pointer to @ref NN_t structure
+ * @param  *model: Pointer to @ref NN_Model_t structure
+ * @param  *arena: Pointer to arena of at least 2 * model->MaxTensor bytes, 4 bytes aligned
+ * @param  arenaSize: Size of arena in bytes
+ * @retval Member of @ref NN_Result_t enumeration
+ */
+NN_Result_t NN_Init(NN_t* nn, const NN_Model_t* model, q7_t* arena, uint32_t arenaSize);
+
+/**
+ * @brief  Runs inference
+ * @param  *nn: Pointer to @ref NN_t structure
+ * @param  *input: Pointer to model->InputSize q7 input elements
+ * @retval Pointer to output tensor inside arena, valid until next run
+ */
+const q7_t* NN_Run(NN_t* nn, const q7_t* input);
+
+/**
+ * @brief  Gets index of largest element, for example class of classifier output
+ * @param  *x: Pointer to q7 elements
+ * @param  count: Number of elements
+ * @retval Index of largest element
+ */
+uint16_t NN_Argmax(const q7_t* x, uint16_t count);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
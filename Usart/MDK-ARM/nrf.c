@@ -1,4 +1,5 @@
 #include "nrf.h"
+#include <string.h>
 
 /* NRF24L01+ registers*/
 #define NRF24L01_REG_CONFIG				0x00	//Configuration Register
@@ -119,6 +120,11 @@
 #define NRF24L01_PLOS_CNT			4 //4 bits
 #define NRF24L01_ARC_CNT			0 //4 bits
 
+/* Feature register */
+#define NRF24L01_EN_DPL				2
+#define NRF24L01_EN_ACK_PAY		1
+#define NRF24L01_EN_DYN_ACK		0
+
 /* FIFO status*/
 #define NRF24L01_TX_REUSE			6
 #define NRF24L01_FIFO_FULL		5
@@ -148,16 +154,26 @@
 #define NRF24L01_WRITE_REGISTER_MASK(reg)	(0x20 | (NRF24L01_REGISTER_MASK & reg)) //Last 5 bits will indicate reg. address
 #define NRF24L01_R_RX_PAYLOAD_MASK				0x61
 #define NRF24L01_W_TX_PAYLOAD_MASK				0xA0
+#define NRF24L01_W_ACK_PAYLOAD_MASK				0xA8
 #define NRF24L01_FLUSH_TX_MASK						0xE1
 #define NRF24L01_FLUSH_RX_MASK						0xE2
 #define NRF24L01_REUSE_TX_PL_MASK					0xE3
 #define NRF24L01_ACTIVATE_MASK						0x50 
+#define NRF24L01_ACTIVATE_DATA						0x73
 #define NRF24L01_R_RX_PL_WID_MASK					0x60
 #define NRF24L01_NOP_MASK									0xFF
 
+/* Time of one transmit attempt besides ARD, PLL settling and longest packet at 250 kbps */
+#define NRF24L01_URGENT_ATTEMPT_US			(NRF24L01_TSTBY2A_US + 1300)
+
 /* Flush FIFOs */
-#define NRF24L01_FLUSH_TX					do { NRF24L01_CSN_LOW; SPI_Send(NRF24L01_SPI, NRF24L01_FLUSH_TX_MASK); NRF24L01_CSN_HIGH; } while (0)
-#define NRF24L01_FLUSH_RX					do { NRF24L01_CSN_LOW; SPI_Send(NRF24L01_SPI, NRF24L01_FLUSH_RX_MASK); NRF24L01_CSN_HIGH; } while (0)
+#define NRF24L01_FLUSH_TX					do { NRF24L01_CSN_LOW; NRF24L01_Status = SPI_Send(NRF24L01_SPI, NRF24L01_FLUSH_TX_MASK); NRF24L01_CSN_HIGH; } while (0)
+#define NRF24L01_FLUSH_RX					do { NRF24L01_CSN_LOW; NRF24L01_Status = SPI_Send(NRF24L01_SPI, NRF24L01_FLUSH_RX_MASK); NRF24L01_CSN_HIGH; } while (0)
+
+/* Registers kept in shadow copy, single byte configuration registers which change only by writing */
+#define NRF24L01_SHADOW_MASK				((0x7FUL << NRF24L01_REG_CONFIG) | (0x0FUL << NRF24L01_REG_RX_ADDR_P2) | \
+											 (0x3FUL << NRF24L01_REG_RX_PW_P0) | (0x03UL << NRF24L01_REG_DYNPD))
+#define NRF24L01_SHADOWED(reg)				((reg) <= NRF24L01_REG_FEATURE && (NRF24L01_SHADOW_MASK & (1UL << (reg))))
 
 #define NRF24L01_TRANSMISSON_OK 			0
 #define NRF24L01_MESSAGE_LOST   			1
@@ -169,6 +185,7 @@ typedef struct {
 	uint8_t Channel;								//Channel selected
 	NRF24L01_OutputPower_t OutPwr;	//Output power
 	NRF24L01_DataRate_t DataRate;		//Data rate
+	uint8_t DynamicPayload;					//Dynamic payload length enabled
 } NRF24L01_t;
 
 /* Private functions */
@@ -180,10 +197,66 @@ void NRF24L01_ReadRegisterMulti(uint8_t reg, uint8_t* data, uint8_t count);
 void NRF24L01_WriteRegisterMulti(uint8_t reg, uint8_t *data, uint8_t count);
 uint8_t NRF24L01_RxFifoEmpty(void);
 void NRF24L01_SoftwareReset(void);
+static void NRF24L01_WritePayload(const uint8_t* data, uint8_t length);
+static void NRF24L01_StreamService(uint8_t flags);
+static void NRF24L01_StreamRefill(void);
+static void NRF24L01_StreamUrgent(void);
+static void NRF24L01_Enter(NRF24L01_Mode_t target);
+static void NRF24L01_RxDrain(void);
+static void NRF24L01_DmaInit(void);
+static void NRF24L01_DmaWrite(uint8_t command, const uint8_t* data, uint8_t length, uint8_t total);
+static void NRF24L01_DmaComplete(void);
 
 /* NRF structure */
 static NRF24L01_t NRF24L01_Struct;
 
+/* Set to 1 when IRQ pin is attached to EXTI */
+volatile uint8_t NRF24L01_IrqEnabled = 0;
+
+/* Nesting depth of NRF24L01_IRQ_LOCK */
+volatile uint8_t NRF24L01_IrqLock = 0;
+
+/* Write transaction in flight, CSN is released by DMA transfer complete interrupt */
+static volatile uint8_t NRF24L01_DmaBusy = 0;
+static uint8_t NRF24L01_DmaTx[NRF24L01_MAX_PAYLOAD + 1];
+static uint8_t NRF24L01_DmaRx[NRF24L01_MAX_PAYLOAD + 1];
+
+/* Shadow copy of configuration registers, valid bit per register */
+static uint8_t NRF24L01_Shadow[NRF24L01_REG_FEATURE + 1];
+static volatile uint32_t NRF24L01_ShadowValid = 0;
+
+/* STATUS register, harvested from first byte of every transaction */
+static volatile uint8_t NRF24L01_Status = 0;
+
+/* Mode state machine, CE goes high at deadline when leaving power down */
+static volatile NRF24L01_Mode_t NRF24L01_Mode = NRF24L01_Mode_PowerDown;
+static volatile NRF24L01_Mode_t NRF24L01_Target = NRF24L01_Mode_PowerDown;
+static volatile uint8_t NRF24L01_CePending = 0;
+static volatile uint32_t NRF24L01_Deadline = 0;
+static uint32_t NRF24L01_CyclesPerUs = 0;
+
+/* Streaming transmit queue, Tail..Fifo are in chip, Fifo..Head wait for space in chip */
+static NRF24L01_Packet_t NRF24L01_TxQueue[NRF24L01_TX_QUEUE_SIZE];
+static volatile uint8_t NRF24L01_TxHead = 0;
+static volatile uint8_t NRF24L01_TxFifo = 0;
+static volatile uint8_t NRF24L01_TxTail = 0;
+static volatile uint8_t NRF24L01_TxActive = 0;
+static NRF24L01_TxStats_t NRF24L01_TxStats;
+
+/* Urgent packet waiting for end of transaction in chip, inserted before tail */
+static NRF24L01_Packet_t NRF24L01_Urgent;
+static volatile uint8_t NRF24L01_UrgentPending = 0;
+static volatile uint32_t NRF24L01_UrgentDeadline = 0;
+
+/* Packets received in interrupt, per pipe written by interrupt at head, read by main loop at tail */
+static NRF24L01_Packet_t NRF24L01_RxQueue[NRF24L01_PIPES][NRF24L01_RX_QUEUE_SIZE];
+static volatile uint8_t NRF24L01_RxHead[NRF24L01_PIPES];
+static volatile uint8_t NRF24L01_RxTail[NRF24L01_PIPES];
+static NRF24L01_PipeStats_t NRF24L01_PipeStats[NRF24L01_PIPES];
+
+/* Events collected in interrupt, cleared by NRF24L01_GetEvents() */
+static volatile uint8_t NRF24L01_Events = 0;
+
 void NRF24L01_InitPins(void) {
 	/* Init pins */
 	/* CNS pin */
@@ -192,8 +265,8 @@ void NRF24L01_InitPins(void) {
 	/* CE pin */
 	GPIO_Init(NRF24L01_CE_PORT, NRF24L01_CE_PIN, GPIO_Mode_OUT, GPIO_OType_PP, GPIO_PuPd_UP, GPIO_Speed_Low);
 	
-	/* CSN high = disable SPI */
-	NRF24L01_CSN_HIGH;
+	/* CSN high = disable SPI, without IRQ unlock as nothing was locked */
+	GPIO_SetPinHigh(NRF24L01_CSN_PORT, NRF24L01_CSN_PIN);
 	
 	/* CE low = disable TX/RX */
 	NRF24L01_CE_LOW;
@@ -202,8 +275,13 @@ void NRF24L01_InitPins(void) {
 uint8_t NRF24L01_Init(uint8_t channel, uint8_t payload_size) {
 	NRF24L01_InitPins();																																									// Initialize CE and CSN pins
 	SPI_Init(NRF24L01_SPI, NRF24L01_SPI_PINS);																														// Initialize SPI
-	if (payload_size > 10) {																																							// Max payload is 32bytes 
-		payload_size = 10;
+	NRF24L01_ShadowValid = 0;																																							// Chip content is unknown until written
+	NRF24L01_DmaInit();																																										// Writes go through SPI DMA
+	DELAY_Init();																																													// DWT cycle counter for mode deadlines
+	NRF24L01_CyclesPerUs = HAL_RCC_GetHCLKFreq() / 1000000;
+	NRF24L01_Mode = NRF24L01_Mode_PowerDown;																															// Software reset clears PWR_UP
+	if (payload_size > NRF24L01_MAX_PAYLOAD) {																														// Max payload is 32bytes 
+		payload_size = NRF24L01_MAX_PAYLOAD;
 	}
 	
 	/* Fill structure */
@@ -211,6 +289,7 @@ uint8_t NRF24L01_Init(uint8_t channel, uint8_t payload_size) {
 	NRF24L01_Struct.PayloadSize = payload_size;
 	NRF24L01_Struct.OutPwr = NRF24L01_OutputPower_0dBm;
 	NRF24L01_Struct.DataRate = NRF24L01_DataRate_2M;
+	NRF24L01_Struct.DynamicPayload = 0;
 	NRF24L01_SoftwareReset();
 	NRF24L01_SetChannel(channel);																																					// Channel select 
 	
@@ -234,8 +313,8 @@ uint8_t NRF24L01_Init(uint8_t channel, uint8_t payload_size) {
 	/* Enable RX addresses */
 	NRF24L01_WriteRegister(NRF24L01_REG_EN_RXADDR, 0x3F);
 
-	/* Auto retransmit delay: 1000 (4x250) us and Up to 15 retransmit trials */
-	NRF24L01_WriteRegister(NRF24L01_REG_SETUP_RETR, 0x4F);
+	/* Auto retransmit delay: 1250 (5x250) us and Up to 15 retransmit trials */
+	NRF24L01_SetRetransmit(1250, 15);
 	
 	/* Dynamic length configurations: No dynamic length */
 	NRF24L01_WriteRegister(NRF24L01_REG_DYNPD, 0x00);
@@ -254,10 +333,63 @@ uint8_t NRF24L01_Init(uint8_t channel, uint8_t payload_size) {
 	return 1;
 }
 
+void NRF24L01_SetDynamicPayload(uint8_t enable) {
+	uint8_t feature = NRF24L01_ReadRegister(NRF24L01_REG_FEATURE);
+	
+	if (enable) {
+		feature |= 1 << NRF24L01_EN_DPL;
+	} else {
+		feature &= ~(1 << NRF24L01_EN_DPL);
+	}
+	NRF24L01_WriteRegister(NRF24L01_REG_FEATURE, feature);
+	
+	/* Older NRF24L01 ignores FEATURE register until it is activated, check chip instead of shadow */
+	NRF24L01_ShadowValid &= ~(1UL << NRF24L01_REG_FEATURE);
+	if (NRF24L01_ReadRegister(NRF24L01_REG_FEATURE) != feature) {
+		NRF24L01_ShadowValid &= ~(1UL << NRF24L01_REG_FEATURE);
+		NRF24L01_CSN_LOW;
+		NRF24L01_Status = SPI_Send(NRF24L01_SPI, NRF24L01_ACTIVATE_MASK);
+		SPI_Send(NRF24L01_SPI, NRF24L01_ACTIVATE_DATA);
+		NRF24L01_CSN_HIGH;
+		NRF24L01_WriteRegister(NRF24L01_REG_FEATURE, feature);
+	}
+	
+	/* Dynamic length on all pipes, requires auto-acknowledgment which is enabled for all pipes */
+	NRF24L01_WriteRegister(NRF24L01_REG_DYNPD, enable ? 0x3F : 0x00);
+	NRF24L01_Struct.DynamicPayload = enable ? 1 : 0;
+}
+
+void NRF24L01_SetAckPayload(uint8_t enable) {
+	uint8_t feature;
+	
+	if (enable) {
+		/* Acknowledgment payloads have dynamic length */
+		NRF24L01_SetDynamicPayload(1);
+	}
+	feature = NRF24L01_ReadRegister(NRF24L01_REG_FEATURE);
+	if (enable) {
+		feature |= 1 << NRF24L01_EN_ACK_PAY;
+	} else {
+		feature &= ~(1 << NRF24L01_EN_ACK_PAY);
+	}
+	NRF24L01_WriteRegister(NRF24L01_REG_FEATURE, feature);
+}
+
+void NRF24L01_WriteAckPayload(uint8_t pipe, const uint8_t* data, uint8_t length) {
+	if (length > NRF24L01_MAX_PAYLOAD) {
+		length = NRF24L01_MAX_PAYLOAD;
+	}
+	NRF24L01_DmaWrite(NRF24L01_W_ACK_PAYLOAD_MASK | (pipe & 0x07), data, length, length);
+}
+
 void NRF24L01_SetMyAddress(uint8_t *adr) {
+	uint8_t ce = (NRF24L01_CE_PORT->ODR & NRF24L01_CE_PIN) != 0;
+	
 	NRF24L01_CE_LOW;
 	NRF24L01_WriteRegisterMulti(NRF24L01_REG_RX_ADDR_P1, adr, 5);
-	NRF24L01_CE_HIGH;
+	if (ce) {
+		NRF24L01_CE_HIGH;
+	}
 }
 
 void NRF24L01_SetTxAddress(uint8_t *adr) {
@@ -287,87 +419,482 @@ uint8_t NRF24L01_ReadBit(uint8_t reg, uint8_t bit) {
 
 uint8_t NRF24L01_ReadRegister(uint8_t reg) {
 	uint8_t value;
+	
+	if (NRF24L01_SHADOWED(reg) && (NRF24L01_ShadowValid & (1UL << reg))) {
+		/* Served from shadow, no SPI traffic */
+		return NRF24L01_Shadow[reg];
+	}
+	
 	NRF24L01_CSN_LOW;
-	SPI_Send(NRF24L01_SPI, NRF24L01_READ_REGISTER_MASK(reg));
+	NRF24L01_Status = SPI_Send(NRF24L01_SPI, NRF24L01_READ_REGISTER_MASK(reg));
 	value = SPI_Send(NRF24L01_SPI, NRF24L01_NOP_MASK);
 	NRF24L01_CSN_HIGH;
 	
+	if (NRF24L01_SHADOWED(reg)) {
+		NRF24L01_Shadow[reg] = value;
+		NRF24L01_ShadowValid |= 1UL << reg;
+	}
+	
 	return value;
 }
 
 void NRF24L01_ReadRegisterMulti(uint8_t reg, uint8_t* data, uint8_t count) {
 	NRF24L01_CSN_LOW;
-	SPI_Send(NRF24L01_SPI, NRF24L01_READ_REGISTER_MASK(reg));
+	NRF24L01_Status = SPI_Send(NRF24L01_SPI, NRF24L01_READ_REGISTER_MASK(reg));
 	SPI_ReadMulti(NRF24L01_SPI, data, NRF24L01_NOP_MASK, count);
 	NRF24L01_CSN_HIGH;
 }
 
 void NRF24L01_WriteRegister(uint8_t reg, uint8_t value) {
-	NRF24L01_CSN_LOW;
-	SPI_Send(NRF24L01_SPI, NRF24L01_WRITE_REGISTER_MASK(reg));
-	SPI_Send(NRF24L01_SPI, value);
-	NRF24L01_CSN_HIGH;
+	if (NRF24L01_SHADOWED(reg)) {
+		if ((NRF24L01_ShadowValid & (1UL << reg)) && NRF24L01_Shadow[reg] == value) {
+			/* Chip already holds this value */
+			return;
+		}
+		NRF24L01_Shadow[reg] = value;
+		NRF24L01_ShadowValid |= 1UL << reg;
+	}
+	NRF24L01_DmaWrite(NRF24L01_WRITE_REGISTER_MASK(reg), &value, 1, 1);
 }
 
 void NRF24L01_WriteRegisterMulti(uint8_t reg, uint8_t *data, uint8_t count) {
-	NRF24L01_CSN_LOW;
-	SPI_Send(NRF24L01_SPI, NRF24L01_WRITE_REGISTER_MASK(reg));
-	SPI_WriteMulti(NRF24L01_SPI, data, count);
-	NRF24L01_CSN_HIGH;
+	NRF24L01_DmaWrite(NRF24L01_WRITE_REGISTER_MASK(reg), data, count, count);
+}
+
+static void NRF24L01_DmaInit(void) {
+	__HAL_RCC_DMA1_CLK_ENABLE();
+	
+	/* RX stream keeps STATUS from first byte, its transfer complete means last byte is on the wire */
+	NRF24L01_DMA_RX_STREAM->CR = 0;
+	NRF24L01_DMA_RX_STREAM->PAR = (uint32_t)&NRF24L01_SPI->DR;
+	NRF24L01_DMA_RX_STREAM->M0AR = (uint32_t)NRF24L01_DmaRx;
+	NRF24L01_DMA_TX_STREAM->CR = 0;
+	NRF24L01_DMA_TX_STREAM->PAR = (uint32_t)&NRF24L01_SPI->DR;
+	NRF24L01_DMA_TX_STREAM->M0AR = (uint32_t)NRF24L01_DmaTx;
+	
+	/* Priority is set in NRF24L01_EnableInterrupt(), after priority grouping is configured */
+	HAL_NVIC_EnableIRQ(NRF24L01_DMA_IRQ);
+}
+
+static void NRF24L01_DmaWrite(uint8_t command, const uint8_t* data, uint8_t length, uint8_t total) {
+	uint8_t i;
+	
+	/* Buffer is shared with interrupt, lock until transfer is started */
+	NRF24L01_IRQ_LOCK;
+	NRF24L01_DmaWait();
+	
+	/* Command and payload in one transaction, padded with zeros to total */
+	NRF24L01_DmaTx[0] = command;
+	for (i = 0; i < total; i++) {
+		NRF24L01_DmaTx[i + 1] = i < length ? data[i] : 0x00;
+	}
+	
+	NRF24L01_DmaBusy = 1;
+	GPIO_SetPinLow(NRF24L01_CSN_PORT, NRF24L01_CSN_PIN);
+	NRF24L01_DMA_RX_STREAM->NDTR = total + 1;
+	NRF24L01_DMA_TX_STREAM->NDTR = total + 1;
+	NRF24L01_DMA_RX_STREAM->CR = (NRF24L01_DMA_CHANNEL << 25) | DMA_SxCR_MINC | DMA_SxCR_TCIE | DMA_SxCR_EN;
+	NRF24L01_DMA_TX_STREAM->CR = (NRF24L01_DMA_CHANNEL << 25) | DMA_SxCR_MINC | DMA_SxCR_DIR_0 | DMA_SxCR_EN;
+	NRF24L01_SPI->CR2 |= SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN;
+	NRF24L01_IRQ_UNLOCK;
+}
+
+static void NRF24L01_DmaComplete(void) {
+	/* Clear all flags of both streams */
+	DMA1->LIFCR = DMA_LIFCR_CTCIF3 | DMA_LIFCR_CHTIF3 | DMA_LIFCR_CTEIF3 | DMA_LIFCR_CDMEIF3 | DMA_LIFCR_CFEIF3;
+	DMA1->HIFCR = DMA_HIFCR_CTCIF4 | DMA_HIFCR_CHTIF4 | DMA_HIFCR_CTEIF4 | DMA_HIFCR_CDMEIF4 | DMA_HIFCR_CFEIF4;
+	NRF24L01_SPI->CR2 &= ~(SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN);
+	GPIO_SetPinHigh(NRF24L01_CSN_PORT, NRF24L01_CSN_PIN);
+	NRF24L01_Status = NRF24L01_DmaRx[0];
+	NRF24L01_DmaBusy = 0;
+}
+
+void NRF24L01_DmaWait(void) {
+	if (!NRF24L01_DmaBusy) {
+		return;
+	}
+	
+	/* Complete transfer here, interrupt may not be able to preempt caller */
+	NVIC_DisableIRQ(NRF24L01_DMA_IRQ);
+	while (NRF24L01_DmaBusy) {
+		if (DMA1->LISR & DMA_LISR_TCIF3) {
+			NRF24L01_DmaComplete();
+		}
+	}
+	NVIC_EnableIRQ(NRF24L01_DMA_IRQ);
+}
+
+void DMA1_Stream3_IRQHandler(void) {
+	if (NRF24L01_DmaBusy && (DMA1->LISR & DMA_LISR_TCIF3)) {
+		/* Release CSN as soon as last byte is transferred */
+		NRF24L01_DmaComplete();
+	}
+}
+
+static void NRF24L01_Enter(NRF24L01_Mode_t target) {
+	NRF24L01_IRQ_LOCK;
+	NRF24L01_CE_LOW;
+	NRF24L01_WriteRegister(NRF24L01_REG_CONFIG, NRF24L01_CONFIG | 1 << NRF24L01_PWR_UP | (target == NRF24L01_Mode_Rx) << NRF24L01_PRIM_RX);
+	if (NRF24L01_Mode == NRF24L01_Mode_PowerDown) {
+		/* Crystal must be stable before CE goes high */
+		NRF24L01_CePending = 1;
+		NRF24L01_Deadline = DWT->CYCCNT + NRF24L01_TPD2STBY_US * NRF24L01_CyclesPerUs;
+	} else if (!NRF24L01_CePending) {
+		NRF24L01_CE_HIGH;
+		NRF24L01_Deadline = DWT->CYCCNT + NRF24L01_TSTBY2A_US * NRF24L01_CyclesPerUs;
+	}
+	/* Otherwise crystal is still starting, its deadline is kept */
+	NRF24L01_Target = target;
+	NRF24L01_Mode = NRF24L01_Mode_Settling;
+	NRF24L01_IRQ_UNLOCK;
+}
+
+NRF24L01_Mode_t NRF24L01_Process(void) {
+	NRF24L01_IRQ_LOCK;
+	if (NRF24L01_UrgentPending && (int32_t)(DWT->CYCCNT - NRF24L01_UrgentDeadline) >= 0) {
+		/* Longest transaction is over without flag, chip did not start one before CE went low */
+		NRF24L01_IRQHandler();
+		if (NRF24L01_UrgentPending) {
+			NRF24L01_StreamUrgent();
+		}
+	}
+	if (NRF24L01_Mode == NRF24L01_Mode_Settling && (int32_t)(DWT->CYCCNT - NRF24L01_Deadline) >= 0) {
+		if (NRF24L01_CePending && NRF24L01_Target != NRF24L01_Mode_Standby) {
+			/* Standby reached, start TX or RX mode */
+			NRF24L01_CePending = 0;
+			NRF24L01_CE_HIGH;
+			NRF24L01_Deadline = DWT->CYCCNT + NRF24L01_TSTBY2A_US * NRF24L01_CyclesPerUs;
+		} else {
+			NRF24L01_CePending = 0;
+			NRF24L01_Mode = NRF24L01_Target;
+		}
+	}
+	NRF24L01_IRQ_UNLOCK;
+	
+	return NRF24L01_Mode;
+}
+
+NRF24L01_Mode_t NRF24L01_GetMode(void) {
+	return NRF24L01_Mode;
 }
 
 void NRF24L01_PowerUpTx(void) {
-	NRF24L01_Clear_Interrupts();
-	NRF24L01_WriteRegister(NRF24L01_REG_CONFIG, NRF24L01_CONFIG | (0 << NRF24L01_PRIM_RX) | (1 << NRF24L01_PWR_UP));
+	/* Callers drop CE first, so no flag was raised since last transaction */
+	if (NRF24L01_GetLastStatus() & (NRF24L01_IRQ_DATA_READY | NRF24L01_IRQ_TRAN_OK | NRF24L01_IRQ_MAX_RT)) {
+		NRF24L01_Clear_Interrupts();
+	}
+	NRF24L01_Enter(NRF24L01_Mode_Tx);
 }
 
 void NRF24L01_PowerUpRx(void) {
+	NRF24L01_IRQ_LOCK;
 	NRF24L01_CE_LOW;																																																// Disable RX/TX mode
 	NRF24L01_FLUSH_RX;																																															// Clear RX buffer
-	NRF24L01_Clear_Interrupts();																																										// Clear interrupts
-	NRF24L01_WriteRegister(NRF24L01_REG_CONFIG, NRF24L01_CONFIG | 1 << NRF24L01_PWR_UP | 1 << NRF24L01_PRIM_RX);		// Setup RX mode
-	NRF24L01_CE_HIGH;																																																// Start listening
+	if (NRF24L01_Status & (NRF24L01_IRQ_DATA_READY | NRF24L01_IRQ_TRAN_OK | NRF24L01_IRQ_MAX_RT)) {									// Clear interrupts, STATUS came with flush
+		NRF24L01_Clear_Interrupts();
+	}
+	NRF24L01_Enter(NRF24L01_Mode_Rx);																																								// Setup RX mode, start listening
+	NRF24L01_IRQ_UNLOCK;
+}
+
+void NRF24L01_Standby(void) {
+	NRF24L01_IRQ_LOCK;
+	NRF24L01_CE_LOW;
+	if (NRF24L01_CePending) {
+		/* Crystal is still starting, CE stays low at deadline */
+		NRF24L01_Target = NRF24L01_Mode_Standby;
+	} else if (NRF24L01_Mode != NRF24L01_Mode_PowerDown) {
+		NRF24L01_Mode = NRF24L01_Mode_Standby;
+	}
+	NRF24L01_IRQ_UNLOCK;
 }
 
 void NRF24L01_PowerDown(void) {
+	NRF24L01_IRQ_LOCK;
 	NRF24L01_CE_LOW;
-	NRF24L01_WriteBit(NRF24L01_REG_CONFIG, NRF24L01_PWR_UP, 0);
+	NRF24L01_WriteRegister(NRF24L01_REG_CONFIG, NRF24L01_CONFIG);
+	NRF24L01_CePending = 0;
+	NRF24L01_Mode = NRF24L01_Mode_PowerDown;
+	NRF24L01_IRQ_UNLOCK;
 }
 
-void NRF24L01_Transmit(uint8_t *data) {
-	uint8_t count = NRF24L01_Struct.PayloadSize;
-	uint16_t counter = 420;	// counter = 1680ticks (STM32f4_Clock) / 4ticks (while) = 420 while loops
-  
-	
+void NRF24L01_Transmit(uint8_t *data, uint8_t length) {
+	NRF24L01_IRQ_LOCK;
 	NRF24L01_CE_LOW;																				// Chip enable put to low, disable it 
-	while(counter-- != 0){}; counter = 420;
-	NRF24L01_PowerUpTx();																		// Go to power up tx mode 
 	NRF24L01_FLUSH_TX;																			// Clear TX FIFO from NRF24L01+ 
-	while(counter-- != 0){}; counter = 420;
-	NRF24L01_CSN_LOW;  																			// Send payload to nRF24L01+ 
-	SPI_Send(NRF24L01_SPI, NRF24L01_W_TX_PAYLOAD_MASK);			// Send write payload command 
-	while(counter-- != 0){}; counter = 420;
-	SPI_WriteMulti(NRF24L01_SPI, data, count);							// Fill payload with data
-	while(counter-- != 0){}; counter = 420;
-	NRF24L01_CSN_HIGH;																			// Disable SPI 
-	NRF24L01_CE_HIGH;																				// Send data! 
+	NRF24L01_WritePayload(data, length);										// Send payload to nRF24L01+ 
+	NRF24L01_PowerUpTx();																		// Go to TX mode, CE goes high now or when chip is settled 
+	NRF24L01_IRQ_UNLOCK;
+}
+
+static void NRF24L01_WritePayload(const uint8_t* data, uint8_t length) {
+	uint8_t count = NRF24L01_Struct.PayloadSize;
+	
+	if (NRF24L01_Struct.DynamicPayload) {
+		count = length > NRF24L01_MAX_PAYLOAD ? NRF24L01_MAX_PAYLOAD : length;
+	} else if (length < count) {
+		count = length;
+	}
+	
+	NRF24L01_DmaWrite(NRF24L01_W_TX_PAYLOAD_MASK, data, count, NRF24L01_Struct.DynamicPayload ? count : NRF24L01_Struct.PayloadSize);
 }
 
-void NRF24L01_GetData(uint8_t* data) {
+uint8_t NRF24L01_Send(const uint8_t* data, uint8_t length) {
+	NRF24L01_Packet_t* packet;
+	
+	if (NRF24L01_SendSpace() == 0) {
+		return 0;
+	}
+	
+	/* Only main loop writes head */
+	packet = &NRF24L01_TxQueue[NRF24L01_TxHead & (NRF24L01_TX_QUEUE_SIZE - 1)];
+	if (length > NRF24L01_MAX_PAYLOAD) {
+		length = NRF24L01_MAX_PAYLOAD;
+	}
+	memcpy(packet->Data, data, length);
+	packet->Length = length;
+	
+	NRF24L01_IRQ_LOCK;
+	NRF24L01_TxHead++;
+	if (!NRF24L01_TxActive) {
+		/* Start stream, CE goes high now or when chip is settled after power down */
+		NRF24L01_TxActive = 1;
+		NRF24L01_CE_LOW;
+		NRF24L01_FLUSH_TX;
+		NRF24L01_StreamRefill();
+		NRF24L01_PowerUpTx();
+	} else {
+		NRF24L01_StreamRefill();
+	}
+	NRF24L01_IRQ_UNLOCK;
+	
+	return 1;
+}
+
+void NRF24L01_SendUrgent(const uint8_t* data, uint8_t length) {
+	uint8_t retr, attempts;
+	
+	if (length > NRF24L01_MAX_PAYLOAD) {
+		length = NRF24L01_MAX_PAYLOAD;
+	}
+	
+	NRF24L01_IRQ_LOCK;
+	/* Chip finishes packet it is sending, including retransmissions, and does not start next one */
+	NRF24L01_CE_LOW;
+	/* Packets completed before CE went low are counted first, so they are not sent again */
+	NRF24L01_IRQHandler();
+	
+	if (!NRF24L01_UrgentPending && NRF24L01_SendSpace() == 0) {
+		/* Slot of urgent packet is reserved now, main loop may not queue into it */
+		NRF24L01_TxHead--;
+		NRF24L01_TxStats.Dropped++;
+	}
+	memcpy(NRF24L01_Urgent.Data, data, length);
+	NRF24L01_Urgent.Length = length;
+	NRF24L01_UrgentPending = 1;
+	
+	if (NRF24L01_TxActive && NRF24L01_TxFifo != NRF24L01_TxTail && !NRF24L01_CePending) {
+		/* CE was high in TX mode, transaction may be running, TX_DS or MAX_RT inserts packet, bounded by ARD * (ARC + 1) */
+		retr = NRF24L01_ReadRegister(NRF24L01_REG_SETUP_RETR);
+		attempts = (retr & 0x0F) + 1;
+		NRF24L01_UrgentDeadline = DWT->CYCCNT + attempts * (((retr >> NRF24L01_ARD) + 1) * 250UL + NRF24L01_URGENT_ATTEMPT_US) * NRF24L01_CyclesPerUs;
+	} else {
+		NRF24L01_StreamUrgent();
+	}
+	NRF24L01_IRQ_UNLOCK;
+}
+
+uint8_t NRF24L01_Receive(uint8_t* data, uint8_t length) {
+	uint8_t pipe, count;
+	
+	for (pipe = 0; pipe < NRF24L01_PIPES; pipe++) {
+		count = NRF24L01_ReceivePipe(pipe, data, length);
+		if (count) {
+			return count;
+		}
+	}
+	
+	return 0;
+}
+
+uint8_t NRF24L01_ReceivePipe(uint8_t pipe, uint8_t* data, uint8_t length) {
+	NRF24L01_Packet_t* packet;
+	
+	if (pipe >= NRF24L01_PIPES || NRF24L01_RxTail[pipe] == NRF24L01_RxHead[pipe]) {
+		return 0;
+	}
+	
+	/* Only main loop writes tail */
+	packet = &NRF24L01_RxQueue[pipe][NRF24L01_RxTail[pipe] & (NRF24L01_RX_QUEUE_SIZE - 1)];
+	if (length > packet->Length) {
+		length = packet->Length;
+	}
+	memcpy(data, packet->Data, length);
+	NRF24L01_RxTail[pipe]++;
+	
+	return length;
+}
+
+void NRF24L01_SetPipeAddress(uint8_t pipe, const uint8_t* adr) {
+	if (pipe < 2) {
+		NRF24L01_WriteRegisterMulti(NRF24L01_REG_RX_ADDR_P0 + pipe, (uint8_t *)adr, 5);
+	} else if (pipe < NRF24L01_PIPES) {
+		NRF24L01_WriteRegister(NRF24L01_REG_RX_ADDR_P0 + pipe, adr[0]);
+	}
+}
+
+void NRF24L01_EnablePipes(uint8_t mask) {
+	NRF24L01_WriteRegister(NRF24L01_REG_EN_RXADDR, mask & 0x3F);
+}
+
+void NRF24L01_GetPipeStats(uint8_t pipe, NRF24L01_PipeStats_t* stats) {
+	if (pipe >= NRF24L01_PIPES) {
+		return;
+	}
+	NRF24L01_IRQ_LOCK;
+	*stats = NRF24L01_PipeStats[pipe];
+	NRF24L01_IRQ_UNLOCK;
+}
+
+static void NRF24L01_RxDrain(void) {
+	NRF24L01_Packet_t* packet;
+	uint8_t dummy[NRF24L01_MAX_PAYLOAD];
+	uint8_t pipe;
+	
+	/* Empty whole 3-deep RX FIFO, RX_DR is raised once for several packets */
+	while (!NRF24L01_RxFifoEmpty()) {
+		/* STATUS of FIFO_STATUS read tells pipe of packet on top */
+		pipe = (NRF24L01_Status >> NRF24L01_RX_P_NO) & 0x07;
+		if (pipe >= NRF24L01_PIPES) {
+			break;
+		}
+		if ((uint8_t)(NRF24L01_RxHead[pipe] - NRF24L01_RxTail[pipe]) >= NRF24L01_RX_QUEUE_SIZE) {
+			/* Newest packets are dropped when main loop does not keep up */
+			NRF24L01_GetData(dummy, sizeof(dummy));
+			NRF24L01_PipeStats[pipe].Dropped++;
+			continue;
+		}
+		packet = &NRF24L01_RxQueue[pipe][NRF24L01_RxHead[pipe] & (NRF24L01_RX_QUEUE_SIZE - 1)];
+		packet->Length = NRF24L01_GetData(packet->Data, NRF24L01_MAX_PAYLOAD);
+		if (packet->Length) {
+			NRF24L01_RxHead[pipe]++;
+			NRF24L01_PipeStats[pipe].Received++;
+			NRF24L01_PipeStats[pipe].LastTick = HAL_GetTick();
+		}
+	}
+}
+
+uint8_t NRF24L01_SendSpace(void) {
+	return NRF24L01_TX_QUEUE_SIZE - (uint8_t)(NRF24L01_TxHead - NRF24L01_TxTail) - NRF24L01_UrgentPending;
+}
+
+uint8_t NRF24L01_SendPending(void) {
+	return (uint8_t)(NRF24L01_TxHead - NRF24L01_TxTail) + NRF24L01_UrgentPending;
+}
+
+void NRF24L01_GetTxStats(NRF24L01_TxStats_t* stats) {
+	NRF24L01_IRQ_LOCK;
+	*stats = NRF24L01_TxStats;
+	NRF24L01_IRQ_UNLOCK;
+}
+
+static void NRF24L01_StreamRefill(void) {
+	NRF24L01_Packet_t* packet;
+	
+	/* Keep chip FIFO topped up, CE stays high so next packet follows without power up */
+	while (NRF24L01_TxFifo != NRF24L01_TxHead && (uint8_t)(NRF24L01_TxFifo - NRF24L01_TxTail) < NRF24L01_TX_FIFO_SIZE) {
+		packet = &NRF24L01_TxQueue[NRF24L01_TxFifo & (NRF24L01_TX_QUEUE_SIZE - 1)];
+		NRF24L01_WritePayload(packet->Data, packet->Length);
+		NRF24L01_TxFifo++;
+	}
+}
+
+static void NRF24L01_StreamUrgent(void) {
+	/* Chip is idle with CE low, packet goes to reserved slot before tail and chip FIFO is written again from it */
+	NRF24L01_UrgentPending = 0;
+	NRF24L01_FLUSH_TX;
+	NRF24L01_TxTail--;
+	NRF24L01_TxQueue[NRF24L01_TxTail & (NRF24L01_TX_QUEUE_SIZE - 1)] = NRF24L01_Urgent;
+	NRF24L01_TxFifo = NRF24L01_TxTail;
+	NRF24L01_StreamRefill();
+	NRF24L01_TxActive = 1;
+	NRF24L01_Enter(NRF24L01_Mode_Tx);
+}
+
+static void NRF24L01_StreamService(uint8_t flags) {
+	uint8_t fifo;
+	
+	if (flags & NRF24L01_IRQ_TRAN_OK) {
+		/* Coalesced TX_DS flags are caught up when FIFO runs empty */
+		fifo = NRF24L01_ReadRegister(NRF24L01_REG_FIFO_STATUS);
+		/* ARC_CNT of last packet, coalesced packets are not counted */
+		NRF24L01_TxStats.Retransmits += NRF24L01_GetRetransmissionsCount();
+		if (NRF24L01_CHECK_BIT(fifo, NRF24L01_TX_EMPTY)) {
+			NRF24L01_TxStats.Sent += (uint8_t)(NRF24L01_TxFifo - NRF24L01_TxTail);
+			NRF24L01_TxTail = NRF24L01_TxFifo;
+		} else if (NRF24L01_TxTail != NRF24L01_TxFifo) {
+			NRF24L01_TxStats.Sent++;
+			NRF24L01_TxTail++;
+		}
+	}
+	if (flags & NRF24L01_IRQ_MAX_RT) {
+		/* Drop failed packet, the rest is written again */
+		NRF24L01_TxStats.Retransmits += NRF24L01_GetRetransmissionsCount();
+		NRF24L01_FLUSH_TX;
+		if (NRF24L01_TxTail != NRF24L01_TxFifo) {
+			NRF24L01_TxStats.Lost++;
+			NRF24L01_TxTail++;
+		}
+		NRF24L01_TxFifo = NRF24L01_TxTail;
+	}
+	
+	if (NRF24L01_UrgentPending) {
+		/* Transaction is over and CE is low, urgent packet goes first */
+		NRF24L01_StreamUrgent();
+	} else if (NRF24L01_TxTail == NRF24L01_TxHead) {
+		/* Stream is finished */
+		NRF24L01_TxActive = 0;
+		NRF24L01_PowerUpRx();
+	} else {
+		NRF24L01_StreamRefill();
+	}
+}
+
+uint8_t NRF24L01_GetData(uint8_t* data, uint8_t length) {
+	uint8_t count = NRF24L01_Struct.PayloadSize;
+	
+	if (NRF24L01_Struct.DynamicPayload) {
+		NRF24L01_CSN_LOW;																											// Read length of top payload
+		NRF24L01_Status = SPI_Send(NRF24L01_SPI, NRF24L01_R_RX_PL_WID_MASK);
+		count = SPI_Send(NRF24L01_SPI, NRF24L01_NOP_MASK);
+		NRF24L01_CSN_HIGH;
+		if (count > NRF24L01_MAX_PAYLOAD) {																		// Corrupted packet must be flushed
+			NRF24L01_FLUSH_RX;
+			NRF24L01_WriteRegister(NRF24L01_REG_STATUS, (1 << NRF24L01_RX_DR));
+			return 0;
+		}
+	}
+	if (count > length) {																										// Rest of payload is discarded with it
+		count = length;
+	}
+	
 	NRF24L01_CSN_LOW;																												// Pull down chip select
-	SPI_Send(NRF24L01_SPI, NRF24L01_R_RX_PAYLOAD_MASK);											// Send read payload command
-	SPI_SendMulti(NRF24L01_SPI, data, data, NRF24L01_Struct.PayloadSize);		// Read payload
+	NRF24L01_Status = SPI_Send(NRF24L01_SPI, NRF24L01_R_RX_PAYLOAD_MASK);		// Send read payload command
+	SPI_ReadMulti(NRF24L01_SPI, data, NRF24L01_NOP_MASK, count);						// Read payload
 	NRF24L01_CSN_HIGH;																											// Pull up chip select 
 	NRF24L01_WriteRegister(NRF24L01_REG_STATUS, (1 << NRF24L01_RX_DR));			// Reset status register, clear RX_DR interrupt flag 
+	
+	return count;
 }
 
 uint8_t NRF24L01_DataReady(void) {
-	uint8_t status = NRF24L01_GetStatus();
+	/* One transaction, STATUS comes with FIFO_STATUS */
+	uint8_t empty = NRF24L01_RxFifoEmpty();
 	
-	if (NRF24L01_CHECK_BIT(status, NRF24L01_RX_DR)) {
+	if (NRF24L01_CHECK_BIT(NRF24L01_Status, NRF24L01_RX_DR)) {
 		return 1;
 	}
-	return !NRF24L01_RxFifoEmpty();
+	return !empty;
 }
 
 uint8_t NRF24L01_RxFifoEmpty(void) {
@@ -383,10 +910,17 @@ uint8_t NRF24L01_GetStatus(void) {
 	status = SPI_Send(NRF24L01_SPI, NRF24L01_NOP_MASK);
 	/* Pull up chip select */
 	NRF24L01_CSN_HIGH;
+	NRF24L01_Status = status;
 	
 	return status;
 }
 
+uint8_t NRF24L01_GetLastStatus(void) {
+	/* Write in flight holds newer STATUS */
+	NRF24L01_DmaWait();
+	return NRF24L01_Status;
+}
+
 NRF24L01_Transmit_Status_t NRF24L01_GetTransmissionStatus(void) {
 	uint8_t status = NRF24L01_GetStatus();
 	if (NRF24L01_CHECK_BIT(status, NRF24L01_TX_DS)) {  							// Successfully sent
@@ -456,6 +990,11 @@ uint8_t NRF24L01_GetRetransmissionsCount(void) {
 	return NRF24L01_ReadRegister(NRF24L01_REG_OBSERVE_TX) & 0x0F;
 }
 
+uint8_t NRF24L01_GetRPD(void) {
+	/* Bit 0, cleared when RX mode is left */
+	return NRF24L01_ReadRegister(NRF24L01_REG_RPD) & 0x01;
+}
+
 void NRF24L01_SetChannel(uint8_t channel) {
 	if (channel <= 125 && channel != NRF24L01_Struct.Channel) {
 		/* Store new channel setting */
@@ -488,11 +1027,82 @@ void NRF24L01_SetRF(NRF24L01_DataRate_t DataRate, NRF24L01_OutputPower_t OutPwr)
 	NRF24L01_WriteRegister(NRF24L01_REG_RF_SETUP, tmp);
 }
 
+void NRF24L01_SetRetransmit(uint16_t delay_us, uint8_t count) {
+	uint8_t ard = delay_us > 250 ? (delay_us - 1) / 250 : 0;
+	
+	if (ard > 0x0F) {
+		ard = 0x0F;
+	}
+	if (count > 0x0F) {
+		count = 0x0F;
+	}
+	/* ARD in steps of 250us from 250us, ARC in low nibble */
+	NRF24L01_WriteRegister(NRF24L01_REG_SETUP_RETR, ard << NRF24L01_ARD | count << NRF24L01_ARC);
+}
+
 uint8_t NRF24L01_Read_Interrupts(NRF24L01_IRQ_t* IRQ) {
 	IRQ->Status = NRF24L01_GetStatus();
+	return IRQ->Status & (NRF24L01_IRQ_DATA_READY | NRF24L01_IRQ_TRAN_OK | NRF24L01_IRQ_MAX_RT);
 }
 
 void NRF24L01_Clear_Interrupts(void) {
 	NRF24L01_WriteRegister(0x07, 0x70);
 }
 
+uint8_t NRF24L01_EnableInterrupt(void) {
+	if (EXTI_Attach(NRF24L01_IRQ_PORT, NRF24L01_IRQ_PIN, EXTI_Trigger_Falling) != EXTI_Result_Ok) {
+		return 0;
+	}
+	EXTI_SetPriority(NRF24L01_IRQ_PIN, NRF24L01_NVIC_PRIORITY, 0);
+	/* Same priority as IRQ pin, so neither interrupt breaks into the other */
+	HAL_NVIC_SetPriority(NRF24L01_DMA_IRQ, NRF24L01_NVIC_PRIORITY, 0);
+	NRF24L01_Events = 0;
+	NRF24L01_IrqEnabled = 1;
+	
+	/* Pin may already be low, falling edge would never come. Line is enabled already, lock keeps handler from entering itself */
+	NRF24L01_IRQ_LOCK;
+	NRF24L01_IRQHandler();
+	NRF24L01_IRQ_UNLOCK;
+	
+	return 1;
+}
+
+void NRF24L01_IRQHandler(void) {
+	uint8_t flags, events = 0;
+	
+	/* Pin stays low until all flags are cleared, flag raised meanwhile would give no new edge */
+	while ((flags = NRF24L01_GetStatus() & (NRF24L01_IRQ_DATA_READY | NRF24L01_IRQ_TRAN_OK | NRF24L01_IRQ_MAX_RT)) != 0) {
+		if (flags & NRF24L01_IRQ_DATA_READY) {
+			/* Before stream service, return to RX mode flushes RX FIFO with acknowledgment payloads */
+			NRF24L01_RxDrain();
+		}
+		if (NRF24L01_TxActive) {
+			/* MAX_RT is cleared after flush, otherwise chip would retry failed packet */
+			NRF24L01_StreamService(flags);
+		}
+		NRF24L01_WriteRegister(NRF24L01_REG_STATUS, flags);
+		events |= flags;
+	}
+	if (events) {
+		NRF24L01_Events |= events;
+		NRF24L01_EventCallback(events);
+	}
+}
+
+uint8_t NRF24L01_GetEvents(void) {
+	uint8_t events;
+	
+	NRF24L01_IRQ_LOCK;
+	events = NRF24L01_Events;
+	NRF24L01_Events = 0;
+	NRF24L01_IRQ_UNLOCK;
+	
+	return events;
+}
+
+__weak void NRF24L01_EventCallback(uint8_t events) {
+	/* NOTE : This function Should not be modified, when the callback is needed,
+	          the NRF24L01_EventCallback could be implemented in the user file
+	 */
+}
+
@@ -8,6 +8,8 @@ extern "C" {
 
 #include "stm32f4xx_hal.h"
 #include "spi.h"
+#include "exti.h"
+#include "delay.h"
 
 /* Default SPI used */
 #ifndef NRF24L01_SPI
@@ -15,6 +17,14 @@ extern "C" {
 #define NRF24L01_SPI_PINS			SPI_PinsPack_2 // PB15 (MOSI) , PB14 (MISO) , PB13 (SCK)
 #endif
 
+/* SPI2 DMA, RX on DMA1 stream 3 and TX on DMA1 stream 4, both channel 0 */
+#ifndef NRF24L01_DMA_RX_STREAM
+#define NRF24L01_DMA_RX_STREAM		DMA1_Stream3
+#define NRF24L01_DMA_TX_STREAM		DMA1_Stream4
+#define NRF24L01_DMA_CHANNEL		0
+#define NRF24L01_DMA_IRQ			DMA1_Stream3_IRQn
+#endif
+
 /* SPI chip enable pin */
 #ifndef NRF24L01_CSN_PIN
 #define NRF24L01_CSN_PORT			GPIOD
@@ -27,11 +37,50 @@ extern "C" {
 #define NRF24L01_CE_PIN				GPIO_PIN_8  // PD8 (CE)
 #endif
 
+/* IRQ pin, active low */
+#ifndef NRF24L01_IRQ_PIN
+#define NRF24L01_IRQ_PORT			GPIOD
+#define NRF24L01_IRQ_PIN			GPIO_PIN_9  // PD9 (IRQ)
+#define NRF24L01_IRQ_CHANNEL		EXTI9_5_IRQn
+#endif
+
+/* Preemption priority of IRQ pin interrupt, below accelerometer data ready */
+#ifndef NRF24L01_NVIC_PRIORITY
+#define NRF24L01_NVIC_PRIORITY		0x02
+#endif
+
 /* Pins configuration */
 #define NRF24L01_CE_LOW				GPIO_SetPinLow(NRF24L01_CE_PORT, NRF24L01_CE_PIN)
-#define NRF24L01_CE_HIGH			GPIO_SetPinHigh(NRF24L01_CE_PORT, NRF24L01_CE_PIN)
-#define NRF24L01_CSN_LOW			GPIO_SetPinLow(NRF24L01_CSN_PORT, NRF24L01_CSN_PIN)
-#define NRF24L01_CSN_HIGH			GPIO_SetPinHigh(NRF24L01_CSN_PORT, NRF24L01_CSN_PIN)
+#define NRF24L01_CE_HIGH			do { NRF24L01_DmaWait(); GPIO_SetPinHigh(NRF24L01_CE_PORT, NRF24L01_CE_PIN); } while (0)
+
+/* IRQ interrupt is held off while main loop works with chip or driver state, locks can be nested */
+#define NRF24L01_IRQ_LOCK			do { NVIC_DisableIRQ(NRF24L01_IRQ_CHANNEL); NRF24L01_IrqLock++; } while (0)
+#define NRF24L01_IRQ_UNLOCK			do { if (--NRF24L01_IrqLock == 0 && NRF24L01_IrqEnabled) NVIC_EnableIRQ(NRF24L01_IRQ_CHANNEL); } while (0)
+#define NRF24L01_CSN_LOW			do { NRF24L01_IRQ_LOCK; NRF24L01_DmaWait(); GPIO_SetPinLow(NRF24L01_CSN_PORT, NRF24L01_CSN_PIN); } while (0)
+#define NRF24L01_CSN_HIGH			do { GPIO_SetPinHigh(NRF24L01_CSN_PORT, NRF24L01_CSN_PIN); NRF24L01_IRQ_UNLOCK; } while (0)
+
+/* Maximal payload length in bytes */
+#define NRF24L01_MAX_PAYLOAD		32
+
+/* Packets queued for streaming transmit, power of 2 */
+#ifndef NRF24L01_TX_QUEUE_SIZE
+#define NRF24L01_TX_QUEUE_SIZE		8
+#endif
+
+/* Packets received in interrupt per pipe, power of 2 */
+#ifndef NRF24L01_RX_QUEUE_SIZE
+#define NRF24L01_RX_QUEUE_SIZE		4
+#endif
+
+/* Number of RX pipes */
+#define NRF24L01_PIPES				6
+
+/* Depth of TX FIFO in chip */
+#define NRF24L01_TX_FIFO_SIZE		3
+
+/* Datasheet timings in microseconds, enforced with DWT cycle counter deadlines */
+#define NRF24L01_TPD2STBY_US		1500 /*!< Power down to standby, crystal oscillator start up */
+#define NRF24L01_TSTBY2A_US			130  /*!< Standby to TX or RX mode, PLL settling */
 
 /* Interrupt masks */
 #define NRF24L01_IRQ_DATA_READY     0x40 /*!< Data ready for receive */
@@ -56,6 +105,32 @@ typedef enum _NRF24L01_Transmit_Status_t {
 	NRF24L01_Transmit_Status_Sending = 0xFF /*!< Message is still sending */
 } NRF24L01_Transmit_Status_t;
 
+typedef enum _NRF24L01_Mode_t {
+	NRF24L01_Mode_PowerDown = 0x00, /*!< Oscillator is stopped, registers are kept */
+	NRF24L01_Mode_Standby,          /*!< Powered up, CE low */
+	NRF24L01_Mode_Settling,         /*!< Waiting for deadline before TX or RX mode is active */
+	NRF24L01_Mode_Tx,               /*!< TX mode, CE high */
+	NRF24L01_Mode_Rx                /*!< RX mode, CE high */
+} NRF24L01_Mode_t;
+
+typedef struct _NRF24L01_Packet_t {
+	uint8_t Length;                       /*!< Number of valid bytes */
+	uint8_t Data[NRF24L01_MAX_PAYLOAD];   /*!< Payload */
+} NRF24L01_Packet_t;
+
+typedef struct _NRF24L01_TxStats_t {
+	uint32_t Sent;   /*!< Streamed packets acknowledged by receiver */
+	uint32_t Lost;   /*!< Streamed packets dropped after maximum number of retransmissions */
+	uint32_t Retransmits; /*!< Retransmissions of streamed packets, lost ones included */
+	uint32_t Dropped; /*!< Queued packets dropped to make room for urgent packet */
+} NRF24L01_TxStats_t;
+
+typedef struct _NRF24L01_PipeStats_t {
+	uint32_t Received;   /*!< Packets queued for main loop */
+	uint32_t Dropped;    /*!< Packets dropped because queue of pipe was full */
+	uint32_t LastTick;   /*!< HAL tick of last received packet in milliseconds */
+} NRF24L01_PipeStats_t;
+
 typedef enum _NRF24L01_DataRate_t {
 	NRF24L01_DataRate_2M = 0x00, /*!< Data rate set to 2Mbps */
 	NRF24L01_DataRate_1M,        /*!< Data rate set to 1Mbps */
@@ -74,11 +149,20 @@ typedef enum _NRF24L01_OutputPower_t {
  * @brief  Initializes NRF24L01+ module
  * @param  channel: channel you will use for communication, from 0 to 125 eg. working frequency from 2.4 to 2.525 GHz
  * @param  payload_size: maximum data to be sent in one packet from one NRF to another.
- * @note   Maximal payload size is 32bytes
+ * @note   Maximal payload size is NRF24L01_MAX_PAYLOAD bytes
  * @retval 1
  */
 uint8_t NRF24L01_Init(uint8_t channel, uint8_t payload_size);
 
+/**
+ * @brief  Enables or disables dynamic payload length on all pipes
+ * @note   Both devices must use the same setting. With dynamic length every packet carries its own length,
+ *         from 1 to NRF24L01_MAX_PAYLOAD bytes, otherwise all packets have "payload_size" bytes
+ * @param  enable: 1 to enable, 0 to use static payload size
+ * @retval None
+ */
+void NRF24L01_SetDynamicPayload(uint8_t enable);
+
 /**
  * @brief  Sets own address. This is used for settings own id when communication with other modules
  * @note   "Own" address of one device must be the same as "TX" address of other device (and vice versa),
@@ -104,9 +188,18 @@ void NRF24L01_SetTxAddress(uint8_t* adr);
  */
 uint8_t NRF24L01_GetRetransmissionsCount(void);
 
+/**
+ * @brief  Gets received power detector of current channel
+ * @note   Valid after at least 170us in RX mode, signal above -64 dBm sets the bit
+ * @param  None
+ * @retval 1 if carrier was detected, 0 otherwise
+ */
+uint8_t NRF24L01_GetRPD(void);
+
 /**
  * @brief  Sets NRF24L01+ to TX mode
- * @note   In this mode is NRF able to send data to another NRF module
+ * @note   In this mode is NRF able to send data to another NRF module.
+ *         Function does not wait, mode is @ref NRF24L01_Mode_Settling until datasheet timings elapse
  * @param  None
  * @retval None
  */
@@ -115,12 +208,37 @@ void NRF24L01_PowerUpTx(void);
 /**
  * @brief  Sets NRF24L01+ to RX mode
  * @note   In this mode is NRF able to receive data from another NRF module.
- *         This is default mode and should be used all the time, except when sending data
+ *         This is default mode and should be used all the time, except when sending data.
+ *         Function does not wait, mode is @ref NRF24L01_Mode_Settling until datasheet timings elapse
  * @param  None
  * @retval None
  */
 void NRF24L01_PowerUpRx(void);
 
+/**
+ * @brief  Advances mode transitions whose deadline has elapsed, call periodically from main loop
+ * @note   Leaving power down takes NRF24L01_TPD2STBY_US before CE may go high
+ * @param  None
+ * @retval Current mode, member of @ref NRF24L01_Mode_t enumeration
+ */
+NRF24L01_Mode_t NRF24L01_Process(void);
+
+/**
+ * @brief  Gets current mode without advancing transitions
+ * @param  None
+ * @retval Current mode, member of @ref NRF24L01_Mode_t enumeration
+ */
+NRF24L01_Mode_t NRF24L01_GetMode(void);
+
+/**
+ * @brief  Sets NRF24L01+ to standby mode
+ * @note   Oscillator keeps running, so TX or RX mode is entered again in NRF24L01_TSTBY2A_US.
+ *         When chip is still starting after power down, it stays in @ref NRF24L01_Mode_Settling
+ * @param  None
+ * @retval None
+ */
+void NRF24L01_Standby(void);
+
 /**
  * @brief  Sets NRF24L01+ to power down mode
  * @note   In power down mode, you are not able to transmit/receive data.
@@ -139,11 +257,123 @@ NRF24L01_Transmit_Status_t NRF24L01_GetTransmissionStatus(void);
 
 /**
  * @brief  Transmits data with NRF24L01+ to another NRF module
- * @param  *data: Pointer to 8-bit array with data.
- *         Maximum length of array can be the same as "payload_size" parameter on initialization
+ * @param  *data: Pointer to 8-bit array with data
+ * @param  length: Number of bytes to send. With static payload size, data are padded with zeros
+ *         to "payload_size" parameter on initialization and longer data are truncated
+ * @retval None
+ */
+void NRF24L01_Transmit(uint8_t *data, uint8_t length);
+
+/**
+ * @brief  Queues packet for streaming transmit
+ * @note   Up to NRF24L01_TX_FIFO_SIZE packets are kept in chip and sent back to back with CE held high.
+ *         FIFO is refilled on TX_DS interrupt and flushed only on MAX_RT, when failed packet is dropped
+ *         and the rest is sent again. Radio returns to RX mode when queue is empty.
+ *         Requires @ref NRF24L01_EnableInterrupt(), do not mix with @ref NRF24L01_Transmit()
+ * @param  *data: Pointer to 8-bit array with data
+ * @param  length: Number of bytes to send, same rules as for @ref NRF24L01_Transmit()
+ * @retval 1 if packet was queued, 0 if queue is full
+ */
+uint8_t NRF24L01_Send(const uint8_t* data, uint8_t length);
+
+/**
+ * @brief  Sends packet ahead of all queued packets, for example alarm
+ * @note   Packet is put before oldest pending packet, chip FIFO is flushed and written again
+ *         with urgent packet first. When chip is sending, CE goes low and packet is inserted when
+ *         that transaction ends with TX_DS or MAX_RT, at latest after ARD * (ARC + 1) in
+ *         @ref NRF24L01_Process(). When queue is full, newest queued packet is dropped. Next urgent
+ *         packet before insertion replaces waiting one
+ * @param  *data: Pointer to 8-bit array with data
+ * @param  length: Number of bytes to send, same rules as for @ref NRF24L01_Transmit()
+ * @retval None
+ */
+void NRF24L01_SendUrgent(const uint8_t* data, uint8_t length);
+
+/**
+ * @brief  Enables or disables payloads in acknowledgments
+ * @note   Receiver can attach data to acknowledgment of received packet, so downlink messages
+ *         reach transmitter without extra air time or mode switch. Enabling also enables dynamic
+ *         payload length, both devices must use the same setting
+ * @param  enable: 1 to enable, 0 to disable
+ * @retval None
+ */
+void NRF24L01_SetAckPayload(uint8_t enable);
+
+/**
+ * @brief  Writes payload for next acknowledgment sent on pipe, used by receiver
+ * @note   Up to 3 acknowledgment payloads can wait in chip
+ * @param  pipe: Pipe number, from 0 to 5
+ * @param  *data: Pointer to 8-bit array with data
+ * @param  length: Number of bytes, from 1 to NRF24L01_MAX_PAYLOAD
+ * @retval None
+ */
+void NRF24L01_WriteAckPayload(uint8_t pipe, const uint8_t* data, uint8_t length);
+
+/**
+ * @brief  Gets packet received in interrupt on any pipe, including acknowledgment payloads
+ * @note   Requires @ref NRF24L01_EnableInterrupt(), RX FIFO is then emptied in interrupt
+ *         into separate queue for each pipe. Pipes are checked from 0 to 5
+ * @param  *data: Pointer to 8-bits array where data will be saved
+ * @param  length: Size of array, longer payload is truncated
+ * @retval Number of bytes saved, 0 if no packet is waiting
+ */
+uint8_t NRF24L01_Receive(uint8_t* data, uint8_t length);
+
+/**
+ * @brief  Gets packet received in interrupt on one pipe
+ * @param  pipe: Pipe number, from 0 to 5
+ * @param  *data: Pointer to 8-bits array where data will be saved
+ * @param  length: Size of array, longer payload is truncated
+ * @retval Number of bytes saved, 0 if no packet is waiting
+ */
+uint8_t NRF24L01_ReceivePipe(uint8_t pipe, uint8_t* data, uint8_t length);
+
+/**
+ * @brief  Sets receive address of pipe, for hub receiving from up to 6 transmitters
+ * @note   Pipes 0 and 1 have full 5-bytes address. Pipes 2 to 5 share upper 4 bytes with pipe 1,
+ *         only first byte of their address is written. Pipe 0 address is also set by
+ *         @ref NRF24L01_SetTxAddress(), as it receives acknowledgments
+ * @param  pipe: Pipe number, from 0 to 5
+ * @param  *adr: Pointer to 5-bytes length array with address
+ * @retval None
+ */
+void NRF24L01_SetPipeAddress(uint8_t pipe, const uint8_t* adr);
+
+/**
+ * @brief  Enables RX pipes
+ * @param  mask: Bit mask of enabled pipes, bit 0 for pipe 0
+ * @retval None
+ */
+void NRF24L01_EnablePipes(uint8_t mask);
+
+/**
+ * @brief  Gets receive statistics of pipe
+ * @param  pipe: Pipe number, from 0 to 5
+ * @param  *stats: Pointer to @ref NRF24L01_PipeStats_t structure to store statistics to
+ * @retval None
+ */
+void NRF24L01_GetPipeStats(uint8_t pipe, NRF24L01_PipeStats_t* stats);
+
+/**
+ * @brief  Gets free space in streaming transmit queue
+ * @param  None
+ * @retval Number of packets which can be queued
+ */
+uint8_t NRF24L01_SendSpace(void);
+
+/**
+ * @brief  Gets number of streamed packets not yet acknowledged or dropped
+ * @param  None
+ * @retval Number of pending packets, 0 when stream is finished
+ */
+uint8_t NRF24L01_SendPending(void);
+
+/**
+ * @brief  Gets streaming transmit statistics
+ * @param  *stats: Pointer to @ref NRF24L01_TxStats_t structure to store statistics to
  * @retval None
  */
-void NRF24L01_Transmit(uint8_t *data);
+void NRF24L01_GetTxStats(NRF24L01_TxStats_t* stats);
 
 /**
  * @brief  Checks if data is ready to be read from NRF24L01+
@@ -157,9 +387,10 @@ uint8_t NRF24L01_DataReady(void);
 /**
  * @brief  Gets data from NRF24L01+
  * @param  *data: Pointer to 8-bits array where data from NRF will be saved
- * @retval None
+ * @param  length: Size of array, longer payload is truncated
+ * @retval Number of bytes saved, 0 if received length was invalid and RX FIFO was flushed
  */
-void NRF24L01_GetData(uint8_t *data);
+uint8_t NRF24L01_GetData(uint8_t *data, uint8_t length);
 
 /**
  * @brief  Sets working channel
@@ -178,6 +409,16 @@ void NRF24L01_SetChannel(uint8_t channel);
  */
 void NRF24L01_SetRF(NRF24L01_DataRate_t DataRate, NRF24L01_OutputPower_t OutPwr);
 
+/**
+ * @brief  Sets automatic retransmission for NRF24L01+
+ * @note   Delay must cover acknowledgment airtime. With 32 bytes ACK payload at least
+ *         500us at 1 and 2Mbps and 1500us at 250kbps, 500us is enough at 250kbps without it
+ * @param  delay_us: Delay between retransmissions, 250 - 4000us, rounded up to multiple of 250us
+ * @param  count: Maximum number of retransmissions, 0 - 15, 0 disables retransmission
+ * @retval None
+ */
+void NRF24L01_SetRetransmit(uint16_t delay_us, uint8_t count);
+
 /**
  * @brief  Gets NRLF+ status register value
  * @param  None
@@ -185,6 +426,14 @@ void NRF24L01_SetRF(NRF24L01_DataRate_t DataRate, NRF24L01_OutputPower_t OutPwr)
  */
 uint8_t NRF24L01_GetStatus(void);
 
+/**
+ * @brief  Gets NRLF+ status register value captured during last SPI transaction
+ * @note   Every command returns STATUS as first byte, so this costs no SPI traffic
+ * @param  None
+ * @retval Status register from NRF
+ */
+uint8_t NRF24L01_GetLastStatus(void);
+
 /**
  * @brief  Reads interrupts from NRF 
  * @param  *IRQ: Pointer to @ref NRF24L01_IRQ_t where IRQ status will be saved
@@ -201,8 +450,42 @@ uint8_t NRF24L01_Read_Interrupts(NRF24L01_IRQ_t* IRQ);
  */
 void NRF24L01_Clear_Interrupts(void);
 
+/**
+ * @brief  Attaches IRQ pin to EXTI, transmission and reception are then reported as events
+ * @note   Call after @ref NRF24L01_Init() and after NVIC priority grouping is set, IRQ pin and DMA
+ *         interrupt priorities are encoded here. All three interrupt sources are enabled in CONFIG register
+ * @param  None
+ * @retval 1 on success, 0 if EXTI line is already used
+ */
+uint8_t NRF24L01_EnableInterrupt(void);
+
+/**
+ * @brief  Reads and clears interrupt flags, call from EXTI_Handler() for IRQ line
+ * @param  None
+ * @retval None
+ */
+void NRF24L01_IRQHandler(void);
+
+/**
+ * @brief  Gets and clears events collected in interrupt
+ * @param  None
+ * @retval Events, combination of NRF24L01_IRQ_DATA_READY, NRF24L01_IRQ_TRAN_OK and NRF24L01_IRQ_MAX_RT
+ */
+uint8_t NRF24L01_GetEvents(void);
+
+/**
+ * @brief  Called from interrupt with new events
+ * @note   With __weak parameter to prevent link errors if not defined by user
+ * @param  events: Combination of NRF24L01_IRQ_DATA_READY, NRF24L01_IRQ_TRAN_OK and NRF24L01_IRQ_MAX_RT
+ * @retval None
+ */
+void NRF24L01_EventCallback(uint8_t events);
+
 /* Private */
 void NRF24L01_WriteRegister(uint8_t reg, uint8_t value);
+void NRF24L01_DmaWait(void);
+extern volatile uint8_t NRF24L01_IrqEnabled;
+extern volatile uint8_t NRF24L01_IrqLock;
 
 /* C++ detection */
 #ifdef __cplusplus
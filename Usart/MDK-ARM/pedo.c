@@ -0,0 +1,145 @@
+#include "pedo.h"
+#include <math.h>
+
+static void PEDO_Biquad(float32_t* c, float32_t fs, float32_t f, uint8_t highPass);
+static void PEDO_Step(PEDO_t* p);
+
+void PEDO_Init(PEDO_t* p, float32_t fs, float32_t sensitivity) {
+	memset(p, 0, sizeof(PEDO_t));
+	p->Fs = fs;
+	p->Sensitivity = sensitivity;
+
+	PEDO_Biquad(&p->Coeffs[0], fs, PEDO_LOW_HZ, 1);
+	PEDO_Biquad(&p->Coeffs[5], fs, PEDO_HIGH_HZ, 0);
+	arm_biquad_cascade_df1_init_f32(&p->Filter, 2, p->Coeffs, p->State);
+}
+
+void PEDO_Process(PEDO_t* p, const LIS3DSH_Axes_t* acc, uint32_t count) {
+	float32_t mag[PEDO_BATCH], y;
+	uint32_t n, i, m2;
+	int32_t xy;
+	uint32_t settle = (uint32_t)(p->Fs * 2.0f);
+	uint32_t minGap = (uint32_t)(p->Fs * PEDO_STEP_MIN_MS / 1000);
+	uint32_t window = (uint32_t)(p->Fs * PEDO_ACTIVITY_MS / 1000);
+	float32_t threshold;
+
+	while (count) {
+		n = count > PEDO_BATCH ? PEDO_BATCH : count;
+
+		/* Magnitude, X and Y are adjacent halfwords */
+		for (i = 0; i < n; i++) {
+			xy = *__SIMD32_CONST(&acc[i].X);
+			m2 = (uint32_t)__SMUAD(xy, xy) + (uint32_t)((int32_t)acc[i].Z * acc[i].Z);
+			arm_sqrt_f32((float32_t)m2, &mag[i]);
+			mag[i] *= p->Sensitivity;
+		}
+		arm_biquad_cascade_df1_f32(&p->Filter, mag, mag, n);
+
+		for (i = 0; i < n; i++) {
+			y = mag[i];
+			p->Time++;
+
+			/* Previous sample was local maximum */
+			if (p->Rising && y < p->Prev && p->Time > settle) {
+				if (p->Prev > PEDO_THRESHOLD_MIN * 0.5f) {
+					p->PeakAverage += (p->Prev - p->PeakAverage) * 0.125f;
+				}
+				threshold = p->PeakAverage * 0.5f;
+				if (threshold < PEDO_THRESHOLD_MIN) {
+					threshold = PEDO_THRESHOLD_MIN;
+				}
+				if (p->Prev > threshold && p->Time - p->LastStep >= minGap) {
+					PEDO_Step(p);
+				}
+			}
+			p->Rising = y > p->Prev;
+			p->Prev = y;
+
+			p->ActivitySum += y < 0.0f ? -y : y;
+			if (++p->ActivityCount >= window) {
+				p->Intensity = p->ActivitySum / p->ActivityCount;
+				p->ActivitySum = 0.0f;
+				p->ActivityCount = 0;
+			}
+		}
+
+		acc += n;
+		count -= n;
+	}
+}
+
+uint8_t PEDO_GetSummary(PEDO_t* p, PEDO_Summary_t* s) {
+	uint32_t elapsed = p->Time - p->SummaryTime;
+
+	if ((float32_t)elapsed < p->Fs * (PEDO_SUMMARY_MS / 1000)) {
+		return 0;
+	}
+
+	s->Steps = p->Steps;
+	s->Cadence = (uint16_t)((p->Steps - p->SummarySteps) * 60.0f * p->Fs / elapsed + 0.5f);
+	s->Intensity = p->Intensity;
+	if (p->Intensity >= PEDO_VIGOROUS_G) {
+		s->Activity = PEDO_Activity_Vigorous;
+	} else if (p->Intensity >= PEDO_MODERATE_G) {
+		s->Activity = PEDO_Activity_Moderate;
+	} else if (p->Intensity >= PEDO_LIGHT_G) {
+		s->Activity = PEDO_Activity_Light;
+	} else {
+		s->Activity = PEDO_Activity_Rest;
+	}
+
+	p->SummaryTime = p->Time;
+	p->SummarySteps = p->Steps;
+	return 1;
+}
+
+void PEDO_Pack(const PEDO_Summary_t* s, uint8_t* data) {
+	uint16_t mg = (uint16_t)__USAT((int32_t)(s->Intensity * 1000.0f), 16);
+
+	data[0] = 'S';
+	data[1] = (uint8_t)s->Steps;
+	data[2] = (uint8_t)(s->Steps >> 8);
+	data[3] = (uint8_t)(s->Steps >> 16);
+	data[4] = (uint8_t)(s->Steps >> 24);
+	data[5] = (uint8_t)__USAT(s->Cadence, 8);
+	data[6] = (uint8_t)s->Activity;
+	data[7] = (uint8_t)mg;
+	data[8] = (uint8_t)(mg >> 8);
+	data[9] = 0;
+}
+
+static void PEDO_Step(PEDO_t* p) {
+	/* Too long pause breaks regular walking */
+	if (p->Time - p->LastStep > (uint32_t)(p->Fs * PEDO_STEP_MAX_MS / 1000)) {
+		p->Pending = 0;
+		p->Regular = 0;
+	}
+	p->LastStep = p->Time;
+
+	if (p->Regular) {
+		p->Steps++;
+	} else if (++p->Pending >= PEDO_CONFIRM_STEPS) {
+		p->Steps += p->Pending;
+		p->Pending = 0;
+		p->Regular = 1;
+	}
+}
+
+/* RBJ biquad in CMSIS order {b0, b1, b2, -a1, -a2}, Q = 0.707 */
+static void PEDO_Biquad(float32_t* c, float32_t fs, float32_t f, uint8_t highPass) {
+	float32_t w = 2.0f * PI * f / fs;
+	float32_t cw = cosf(w);
+	float32_t alpha = sinf(w) / (2.0f * 0.7071f);
+	float32_t a0 = 1.0f + alpha;
+
+	if (highPass) {
+		c[0] = (1.0f + cw) * 0.5f / a0;
+		c[1] = -(1.0f + cw) / a0;
+	} else {
+		c[0] = (1.0f - cw) * 0.5f / a0;
+		c[1] = (1.0f - cw) / a0;
+	}
+	c[2] = c[0];
+	c[3] = 2.0f * cw / a0;
+	c[4] = -(1.0f - alpha) / a0;
+}
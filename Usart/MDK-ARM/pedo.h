@@ -0,0 +1,124 @@
+#ifndef PEDO_H
+#define PEDO_H 100
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Step counter and activity level from batches of accelerometer FIFO samples.
+ *
+ * Each batch is processed as a whole:
+ *  - magnitude of acceleration, X^2 + Y^2 with one __SMUAD() per sample
+ *  - band pass PEDO_LOW_HZ - PEDO_HIGH_HZ, two biquads with arm_biquad_cascade_df1_f32()
+ *  - local maxima above adaptive threshold, half of average peak height but at least
+ *    PEDO_THRESHOLD_MIN, at least PEDO_STEP_MIN_MS apart
+ *
+ * Steps are counted only after PEDO_CONFIRM_STEPS regular steps, each at most
+ * PEDO_STEP_MAX_MS after previous one, so single bumps are ignored.
+ * Activity level is mean absolute band passed acceleration over PEDO_ACTIVITY_MS.
+ */
+
+#include "stm32f4xx_hal.h"
+#include "arm_math.h"
+#include "lis3dsh.h"
+
+/* Band of walking and running */
+#define PEDO_LOW_HZ					0.5f
+#define PEDO_HIGH_HZ				3.0f
+
+/* Step detection */
+#define PEDO_THRESHOLD_MIN			0.05f
+#define PEDO_STEP_MIN_MS			250
+#define PEDO_STEP_MAX_MS			2000
+#define PEDO_CONFIRM_STEPS			4
+
+/* Activity level thresholds in g and averaging window */
+#define PEDO_ACTIVITY_MS			10000UL
+#define PEDO_LIGHT_G				0.02f
+#define PEDO_MODERATE_G				0.1f
+#define PEDO_VIGOROUS_G				0.3f
+
+/* Interval between summaries in milliseconds */
+#define PEDO_SUMMARY_MS				60000UL
+
+/* Maximal samples processed at once, longer batches are split */
+#define PEDO_BATCH					LIS3DSH_FIFO_SIZE
+
+typedef enum {
+	PEDO_Activity_Rest = 0x00,  /*!< No significant movement */
+	PEDO_Activity_Light,        /*!< Light movement */
+	PEDO_Activity_Moderate,     /*!< Walking */
+	PEDO_Activity_Vigorous      /*!< Running */
+} PEDO_Activity_t;
+
+typedef struct {
+	uint32_t Steps;             /*!< Steps since start */
+	uint16_t Cadence;           /*!< Steps per minute in last summary interval */
+	PEDO_Activity_t Activity;   /*!< Last activity level */
+	float32_t Intensity;        /*!< Last mean absolute band passed acceleration in g */
+} PEDO_Summary_t;
+
+typedef struct {
+	arm_biquad_casd_df1_inst_f32 Filter;
+	float32_t Coeffs[10];       /*!< High pass and low pass stage */
+	float32_t State[8];
+	float32_t Fs;               /*!< Sample rate in Hz */
+	float32_t Sensitivity;      /*!< Value of one digit in g */
+	float32_t Prev;             /*!< Previous filtered sample */
+	uint8_t Rising;             /*!< Set to 1 while signal rises */
+	float32_t PeakAverage;      /*!< Average height of local maxima */
+	uint32_t Time;              /*!< Samples since start */
+	uint32_t LastStep;          /*!< Time of last step */
+	uint8_t Pending;            /*!< Regular steps not counted yet */
+	uint8_t Regular;            /*!< Set to 1 when steps are counted directly */
+	uint32_t Steps;             /*!< Counted steps */
+	float32_t ActivitySum;      /*!< Sum of absolute filtered samples in window */
+	uint32_t ActivityCount;     /*!< Samples in window */
+	float32_t Intensity;        /*!< Mean of last complete window */
+	uint32_t SummaryTime;       /*!< Time of last summary */
+	uint32_t SummarySteps;      /*!< Steps at last summary */
+} PEDO_t;
+
+/**
+ * @brief  Initializes step counter
+ * @param  *p: Pointer to @ref PEDO_t structure
+ * @param  fs: Accelerometer output data rate in Hz
+ * @param  sensitivity: Value of one digit in g, from @ref LIS3DSH_GetSensitivity()
+ * @retval None
+ */
+void PEDO_Init(PEDO_t* p, float32_t fs, float32_t sensitivity);
+
+/**
+ * @brief  Processes batch of accelerometer samples
+ * @param  *p: Pointer to @ref PEDO_t structure
+ * @param  *acc: Pointer to raw samples, oldest first
+ * @param  count: Number of samples
+ * @retval None
+ */
+void PEDO_Process(PEDO_t* p, const LIS3DSH_Axes_t* acc, uint32_t count);
+
+/**
+ * @brief  Gets summary once per PEDO_SUMMARY_MS
+ * @param  *p: Pointer to @ref PEDO_t structure
+ * @param  *s: Pointer to @ref PEDO_Summary_t structure to store summary to
+ * @retval 1 if new summary is available, 0 otherwise
+ */
+uint8_t PEDO_GetSummary(PEDO_t* p, PEDO_Summary_t* s);
+
+/**
+ * @brief  Packs summary to 10 bytes for transmission
+ * @note   Layout: 'S', steps (LE, 32 bits), cadence, activity, intensity in mg (LE), 0
+ * @param  *s: Pointer to @ref PEDO_Summary_t structure
+ * @param  *data: Pointer to 10 bytes output buffer
+ * @retval None
+ */
+void PEDO_Pack(const PEDO_Summary_t* s, uint8_t* data);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
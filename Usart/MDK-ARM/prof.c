@@ -0,0 +1,25 @@
+#include "prof.h"
+#include <string.h>
+
+PROF_Counter_t PROF_Counters[PROF_Stage_Count];
+
+void PROF_Init(void) {
+	DELAY_Init();
+	memset(PROF_Counters, 0, sizeof(PROF_Counters));
+}
+
+void PROF_Stop(PROF_Stage_t stage, uint32_t start) {
+	PROF_Counter_t* c = &PROF_Counters[stage];
+	uint32_t cycles = DWT->CYCCNT - start;
+
+	c->Last = cycles;
+	if (cycles > c->Max) {
+		c->Max = cycles;
+	}
+	c->Total += cycles;
+	c->Calls++;
+}
+
+void PROF_Skip(PROF_Stage_t stage) {
+	PROF_Counters[stage].Skipped++;
+}
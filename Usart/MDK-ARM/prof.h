@@ -0,0 +1,81 @@
+#ifndef PROF_H
+#define PROF_H 100
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Per-stage cycle counters for block processing pipeline, based on DWT cycle counter.
+ *
+ * Each stage is measured with:
+ *
+ *   uint32_t start = PROF_Start();
+ *   ...
+ *   PROF_Stop(PROF_Stage_Fusion, start);
+ *
+ * Stages skipped by signal quality gate are counted with @ref PROF_Skip(),
+ * counters can be watched in debugger through PROF_Counters array.
+ */
+
+#include "stm32f4xx_hal.h"
+#include "delay.h"
+
+typedef enum {
+	PROF_Stage_Cond = 0x00, /*!< ADC block conditioning */
+	PROF_Stage_Sqi,         /*!< Signal quality index */
+	PROF_Stage_Resample,    /*!< Accelerometer resampling */
+	PROF_Stage_Fusion,      /*!< Kalman motion compensation */
+	PROF_Stage_Hrv,         /*!< Heart rate variability */
+	PROF_Stage_Resp,        /*!< Respiration rate */
+	PROF_Stage_Gesture,     /*!< Gesture recognition */
+	PROF_Stage_Steps,       /*!< Step counter */
+	PROF_Stage_Count        /*!< Number of stages */
+} PROF_Stage_t;
+
+typedef struct {
+	uint32_t Last;    /*!< Cycles of last run */
+	uint32_t Max;     /*!< Maximal cycles of one run */
+	uint64_t Total;   /*!< Sum of cycles of all runs */
+	uint32_t Calls;   /*!< Number of runs */
+	uint32_t Skipped; /*!< Number of skipped runs */
+} PROF_Counter_t;
+
+extern PROF_Counter_t PROF_Counters[PROF_Stage_Count];
+
+/**
+ * @brief  Starts DWT cycle counter and clears all counters
+ * @param  None
+ * @retval None
+ */
+void PROF_Init(void);
+
+/**
+ * @brief  Gets start time of measured stage
+ * @param  None
+ * @retval Current cycle counter value
+ */
+#define PROF_Start()				(DWT->CYCCNT)
+
+/**
+ * @brief  Ends measurement of stage
+ * @param  stage: Measured stage. This parameter can be a value of @ref PROF_Stage_t enumeration
+ * @param  start: Value returned by @ref PROF_Start()
+ * @retval None
+ */
+void PROF_Stop(PROF_Stage_t stage, uint32_t start);
+
+/**
+ * @brief  Counts skipped stage
+ * @param  stage: Skipped stage. This parameter can be a value of @ref PROF_Stage_t enumeration
+ * @retval None
+ */
+void PROF_Skip(PROF_Stage_t stage);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
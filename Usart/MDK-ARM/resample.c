@@ -0,0 +1,105 @@
+#include "resample.h"
+#include <math.h>
+
+void RESAMPLE_Design_q15(q15_t* coeffs, uint16_t numTaps, uint8_t L, uint8_t M) {
+	float32_t fc = 0.5f / (L > M ? L : M);
+	float32_t mid = (numTaps - 1) * 0.5f;
+	float32_t t, h;
+	uint16_t n;
+
+	for (n = 0; n < numTaps; n++) {
+		t = n - mid;
+		h = t == 0.0f ? 2.0f * fc : sinf(2.0f * PI * fc * t) / (PI * t);
+		h *= (0.54f - 0.46f * cosf(2.0f * PI * n / (numTaps - 1))) * L;
+
+		/* Time reversed order */
+		coeffs[numTaps - 1 - n] = (q15_t)__SSAT((q31_t)(h * 32768.0f + (h < 0.0f ? -0.5f : 0.5f)), 16);
+	}
+}
+
+RESAMPLE_Result_t RESAMPLE_Init(RESAMPLE_t* r, uint8_t L, uint8_t M, uint16_t numTaps, q15_t* coeffs, q15_t* branches, q15_t* state, uint32_t blockSize) {
+	uint16_t p, i;
+
+	if (L == 0 || M == 0 || numTaps % L) {
+		return RESAMPLE_Result_Error;
+	}
+
+	r->L = L;
+	r->M = M;
+	r->PhaseLength = numTaps / L;
+	r->Phase = 0;
+	r->Offset = 0;
+	r->Branches = branches;
+	r->State = state;
+
+	if (M == 1) {
+		r->Mode = RESAMPLE_Mode_Interpolate;
+		arm_fir_interpolate_init_q15(&r->Interp, L, numTaps, coeffs, state, blockSize);
+	} else if (L == 1) {
+		r->Mode = RESAMPLE_Mode_Decimate;
+		if (arm_fir_decimate_init_q15(&r->Decim, numTaps, M, coeffs, state, blockSize) != ARM_MATH_SUCCESS) {
+			return RESAMPLE_Result_Error;
+		}
+	} else {
+		r->Mode = RESAMPLE_Mode_Rational;
+		if (branches == NULL) {
+			return RESAMPLE_Result_Error;
+		}
+
+		/* Branch p, oldest sample first, same indexing as arm_fir_interpolate_q15() */
+		for (p = 0; p < L; p++) {
+			for (i = 0; i < r->PhaseLength; i++) {
+				branches[p * r->PhaseLength + i] = coeffs[(L - 1 - p) + i * L];
+			}
+		}
+		memset(state, 0, (r->PhaseLength + blockSize - 1) * sizeof(q15_t));
+	}
+
+	return RESAMPLE_Result_Ok;
+}
+
+uint32_t RESAMPLE_Process_q15(RESAMPLE_t* r, const q15_t* src, q15_t* dst, uint32_t count) {
+	uint16_t taps = r->PhaseLength;
+	q15_t* hist = r->State + taps - 1;
+	uint32_t out = 0;
+
+	if (r->Mode == RESAMPLE_Mode_Interpolate) {
+		arm_fir_interpolate_q15(&r->Interp, (q15_t *)src, dst, count);
+		return count * r->L;
+	}
+	if (r->Mode == RESAMPLE_Mode_Decimate) {
+		arm_fir_decimate_q15(&r->Decim, (q15_t *)src, dst, count);
+		return count / r->M;
+	}
+
+	/* State holds taps - 1 previous samples followed by current block */
+	memcpy(hist, src, count * sizeof(q15_t));
+
+	while (r->Offset < count) {
+		q15_t* x = hist + r->Offset - (taps - 1);
+		q15_t* b = r->Branches + r->Phase * taps;
+		q63_t acc = 0;
+		uint16_t i = taps >> 1;
+
+		/* Two taps per instruction */
+		while (i-- > 0) {
+			acc = __SMLALD(*__SIMD32(x)++, *__SIMD32(b)++, acc);
+		}
+		if (taps & 1) {
+			acc += (q31_t)*x * *b;
+		}
+		*dst++ = (q15_t)__SSAT((q31_t)(acc >> 15), 16);
+		out++;
+
+		/* Next output is M / L input samples later */
+		r->Phase += r->M;
+		r->Offset += r->Phase / r->L;
+		r->Phase %= r->L;
+	}
+	r->Offset -= count;
+
+	/* Keep last taps - 1 samples as history */
+	memmove(r->State, r->State + count, (taps - 1) * sizeof(q15_t));
+
+	return out;
+}
@@ -0,0 +1,97 @@
+#ifndef RESAMPLE_H
+#define RESAMPLE_H 100
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Rational L/M sample rate converter for q15 streams.
+ *
+ * Integer factors use CMSIS functions directly:
+ *  - M = 1: arm_fir_interpolate_q15()
+ *  - L = 1: arm_fir_decimate_q15()
+ *
+ * Other ratios use polyphase structure with the same prototype filter as
+ * arm_fir_interpolate_q15(), but only the branch needed for each output sample is evaluated,
+ * no intermediate samples at L times input rate are computed.
+ * Each output sample costs numTaps / L multiply-accumulates.
+ *
+ * Coefficients are in time reversed order as for CMSIS FIR functions, numTaps must be
+ * multiple of L. All memory is provided by user, for maximal block size B:
+ *  - q15_t branches[numTaps], only for rational ratio, can be shared by instances with the same filter
+ *  - q15_t state[numTaps / L + B - 1] for interpolation and rational ratio
+ *  - q15_t state[numTaps + B - 1] for decimation
+ *
+ * Output has at most ceil(B * L / M) samples per block.
+ */
+
+#include "stm32f4xx_hal.h"
+#include "arm_math.h"
+
+typedef enum {
+	RESAMPLE_Result_Ok = 0x00, /*!< Everything OK */
+	RESAMPLE_Result_Error      /*!< Invalid factors or filter length */
+} RESAMPLE_Result_t;
+
+typedef enum {
+	RESAMPLE_Mode_Interpolate = 0x00, /*!< M = 1 */
+	RESAMPLE_Mode_Decimate,           /*!< L = 1 */
+	RESAMPLE_Mode_Rational            /*!< General L/M */
+} RESAMPLE_Mode_t;
+
+typedef struct {
+	RESAMPLE_Mode_t Mode;                   /*!< Conversion mode */
+	uint8_t L;                              /*!< Interpolation factor */
+	uint8_t M;                              /*!< Decimation factor */
+	uint16_t PhaseLength;                   /*!< Taps per polyphase branch */
+	uint16_t Phase;                         /*!< Branch of next output sample */
+	uint32_t Offset;                        /*!< Input position of next output sample relative to current block */
+	q15_t* Branches;                        /*!< Reordered coefficients, PhaseLength per branch */
+	q15_t* State;                           /*!< History and current block */
+	arm_fir_interpolate_instance_q15 Interp; /*!< Used for M = 1 */
+	arm_fir_decimate_instance_q15 Decim;    /*!< Used for L = 1 */
+} RESAMPLE_t;
+
+/**
+ * @brief  Designs lowpass prototype filter for L/M conversion (Hamming windowed sinc)
+ * @note   Cutoff is at lower of input and output Nyquist frequencies, gain is L
+ * @param  *coeffs: Pointer to numTaps coefficients
+ * @param  numTaps: Filter length, multiple of L
+ * @param  L: Interpolation factor
+ * @param  M: Decimation factor
+ * @retval None
+ */
+void RESAMPLE_Design_q15(q15_t* coeffs, uint16_t numTaps, uint8_t L, uint8_t M);
+
+/**
+ * @brief  Initializes resampler
+ * @param  *r: Pointer to @ref RESAMPLE_t structure
+ * @param  L: Interpolation factor
+ * @param  M: Decimation factor
+ * @param  numTaps: Filter length, multiple of L
+ * @param  *coeffs: Pointer to prototype filter coefficients
+ * @param  *branches: Pointer to numTaps coefficients buffer for rational ratio, can be NULL otherwise
+ * @param  *state: Pointer to state buffer
+ * @param  blockSize: Maximal number of input samples per call, multiple of M for decimation
+ * @retval Member of @ref RESAMPLE_Result_t enumeration
+ */
+RESAMPLE_Result_t RESAMPLE_Init(RESAMPLE_t* r, uint8_t L, uint8_t M, uint16_t numTaps, q15_t* coeffs, q15_t* branches, q15_t* state, uint32_t blockSize);
+
+/**
+ * @brief  Converts block of samples
+ * @param  *r: Pointer to @ref RESAMPLE_t structure
+ * @param  *src: Pointer to input samples
+ * @param  *dst: Pointer to output samples
+ * @param  count: Number of input samples, up to blockSize, multiple of M for decimation
+ * @retval Number of output samples
+ */
+uint32_t RESAMPLE_Process_q15(RESAMPLE_t* r, const q15_t* src, q15_t* dst, uint32_t count);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,156 @@
+#include "resp.h"
+#include <math.h>
+
+/* CIC gain is R^3, input is shifted by 4 bits as 12-bit ADC leaves them empty */
+#define RESP_CIC_NORM				((uint32_t)(68719476736ULL / ((uint64_t)RESP_CIC_R * RESP_CIC_R * RESP_CIC_R)))
+
+static void RESP_Estimate(RESP_t* r);
+
+RESP_Result_t RESP_Init(RESP_t* r, float32_t fs) {
+	float32_t fc, mid = (RESP_FIR_TAPS - 1) * 0.5f;
+	float32_t t, h;
+	uint16_t n;
+
+	memset(r, 0, sizeof(RESP_t));
+
+	/* Windowed sinc at 32 Hz intermediate rate, symmetric so order does not matter */
+	fc = RESP_FIR_CUTOFF * RESP_CIC_R / fs;
+	for (n = 0; n < RESP_FIR_TAPS; n++) {
+		t = n - mid;
+		h = sinf(2.0f * PI * fc * t) / (PI * t);
+		h *= 0.54f - 0.46f * cosf(2.0f * PI * n / (RESP_FIR_TAPS - 1));
+		r->Coeffs[n] = (q15_t)__SSAT((q31_t)(h * 32768.0f + (h < 0.0f ? -0.5f : 0.5f)), 16);
+	}
+	if (arm_fir_decimate_init_q15(&r->Fir, RESP_FIR_TAPS, RESP_FIR_M, r->Coeffs, r->FirState, RESP_FIR_M) != ARM_MATH_SUCCESS) {
+		return RESP_Result_Error;
+	}
+
+	r->Fs = fs / (RESP_CIC_R * RESP_FIR_M);
+
+	return RESP_Result_Ok;
+}
+
+uint8_t RESP_Process_q15(RESP_t* r, const q15_t* x, uint32_t count) {
+	uint32_t i0 = r->Integrator[0], i1 = r->Integrator[1], i2 = r->Integrator[2];
+	uint32_t d0, d1, d2;
+	uint8_t updated = 0;
+	q15_t out;
+
+	while (count--) {
+		/* Integrators at input rate */
+		i0 += (uint32_t)(*x++ >> 4);
+		i1 += i0;
+		i2 += i1;
+
+		if (++r->Phase < RESP_CIC_R) {
+			continue;
+		}
+		r->Phase = 0;
+
+		/* Combs at decimated rate */
+		d0 = i2 - r->Comb[0];
+		r->Comb[0] = i2;
+		d1 = d0 - r->Comb[1];
+		r->Comb[1] = d0;
+		d2 = d1 - r->Comb[2];
+		r->Comb[2] = d1;
+
+		r->Mid[r->MidCount++] = (q15_t)__SSAT((q31_t)(((int64_t)(int32_t)d2 * RESP_CIC_NORM) >> 32), 16);
+		if (r->MidCount < RESP_FIR_M) {
+			continue;
+		}
+		r->MidCount = 0;
+
+		arm_fir_decimate_q15(&r->Fir, r->Mid, &out, RESP_FIR_M);
+		r->Window[r->Head] = out;
+		if (++r->Head == RESP_WINDOW) {
+			r->Head = 0;
+		}
+		if (r->Count < RESP_WINDOW) {
+			r->Count++;
+		}
+
+		if (++r->Fresh >= RESP_HOP && r->Count == RESP_WINDOW) {
+			r->Fresh = 0;
+			RESP_Estimate(r);
+			updated = 1;
+		}
+	}
+
+	r->Integrator[0] = i0;
+	r->Integrator[1] = i1;
+	r->Integrator[2] = i2;
+
+	return updated;
+}
+
+static void RESP_Estimate(RESP_t* r) {
+	q15_t* lin = r->Linear;
+	float32_t* acf = r->Acf;
+	float32_t best = 0.0f, a, b, c, lag;
+	uint16_t lagMin = (uint16_t)(r->Fs * 60.0f / RESP_RATE_MAX);
+	uint16_t lagMax = (uint16_t)(r->Fs * 60.0f / RESP_RATE_MIN);
+	uint16_t i, k, peak = 0;
+	int32_t sum = 0;
+	q63_t dot;
+	q15_t mean;
+
+	/* Oldest first, mean removed, halved so difference fits q15 */
+	for (i = 0; i < RESP_WINDOW; i++) {
+		sum += r->Window[i];
+	}
+	mean = (q15_t)(sum / RESP_WINDOW);
+	for (i = 0, k = r->Head; i < RESP_WINDOW; i++) {
+		lin[i] = (q15_t)((r->Window[k] - mean) >> 1);
+		if (++k == RESP_WINDOW) {
+			k = 0;
+		}
+	}
+
+	arm_dot_prod_q15(lin, lin, RESP_WINDOW, &dot);
+	if (dot == 0 || lagMax + 1 >= RESP_WINDOW) {
+		r->Rate = 0.0f;
+		r->Quality = 0.0f;
+		return;
+	}
+	a = (float32_t)dot / RESP_WINDOW;
+
+	/* Unbiased autocorrelation normalized to lag 0 */
+	for (k = lagMin - 1; k <= lagMax + 1; k++) {
+		arm_dot_prod_q15(lin, lin + k, RESP_WINDOW - k, &dot);
+		acf[k] = (float32_t)dot / (RESP_WINDOW - k) / a;
+	}
+
+	/* Highest local maximum in range */
+	for (k = lagMin; k <= lagMax; k++) {
+		if (acf[k] > acf[k - 1] && acf[k] >= acf[k + 1] && acf[k] > best) {
+			best = acf[k];
+			peak = k;
+		}
+	}
+
+	/* Multiples of period are almost as high, take the first comparable peak */
+	for (k = lagMin; k < peak; k++) {
+		if (acf[k] > acf[k - 1] && acf[k] >= acf[k + 1] && acf[k] >= best * 0.8f) {
+			best = acf[k];
+			peak = k;
+			break;
+		}
+	}
+
+	r->Quality = best;
+	if (peak == 0 || best < RESP_QUALITY_MIN) {
+		r->Rate = 0.0f;
+		return;
+	}
+
+	/* Parabolic interpolation of lag */
+	a = acf[peak - 1];
+	b = acf[peak];
+	c = acf[peak + 1];
+	lag = peak;
+	if (a - 2.0f * b + c != 0.0f) {
+		lag += 0.5f * (a - c) / (a - 2.0f * b + c);
+	}
+	r->Rate = 60.0f * r->Fs / lag;
+}
@@ -0,0 +1,99 @@
+#ifndef RESP_H
+#define RESP_H 100
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Respiration rate from baseline of optical signal.
+ *
+ * Breathing modulates baseline at 0.1 - 0.7 Hz, so signal is first brought down
+ * to a few Hz in two stages:
+ *  - 3rd order CIC decimator by RESP_CIC_R, only additions per input sample
+ *  - arm_fir_decimate_q15() by RESP_FIR_M, low pass at RESP_FIR_CUTOFF Hz
+ *
+ * At 1920 Hz input this gives 4 Hz. Last RESP_WINDOW decimated samples are kept
+ * and every RESP_HOP new samples rate is estimated from highest autocorrelation
+ * peak with lag between RESP_RATE_MAX and RESP_RATE_MIN breaths per minute.
+ */
+
+#include "stm32f4xx_hal.h"
+#include "arm_math.h"
+
+/* CIC decimation, 1920 Hz to 32 Hz */
+#define RESP_CIC_R					60
+
+/* FIR decimation, 32 Hz to 4 Hz, long enough to suppress cardiac pulse above 1.3 Hz */
+#define RESP_FIR_M					8
+#define RESP_FIR_TAPS				96
+#define RESP_FIR_CUTOFF				0.75f
+
+/* Autocorrelation window and update interval in decimated samples */
+#define RESP_WINDOW					128
+#define RESP_HOP					16
+
+/* Detected rate range in breaths per minute */
+#define RESP_RATE_MIN				6
+#define RESP_RATE_MAX				42
+
+/* Minimal normalized autocorrelation of accepted peak */
+#define RESP_QUALITY_MIN			0.3f
+
+typedef enum {
+	RESP_Result_Ok = 0x00,    /*!< Everything OK */
+	RESP_Result_Error         /*!< Invalid parameters */
+} RESP_Result_t;
+
+typedef struct {
+	uint32_t Integrator[3];   /*!< CIC integrators, wrap around by design */
+	uint32_t Comb[3];         /*!< CIC comb delays */
+	uint8_t Phase;            /*!< Input samples since last CIC output */
+	arm_fir_decimate_instance_q15 Fir;
+	q15_t Coeffs[RESP_FIR_TAPS];
+	q15_t FirState[RESP_FIR_TAPS + RESP_FIR_M - 1];
+	q15_t Mid[RESP_FIR_M];    /*!< CIC outputs waiting for FIR */
+	uint8_t MidCount;         /*!< Number of samples in Mid */
+	q15_t Window[RESP_WINDOW];/*!< Ring of decimated samples */
+	uint16_t Head;            /*!< Next write position in Window */
+	uint16_t Count;           /*!< Number of valid samples in Window */
+	uint16_t Fresh;           /*!< Samples since last estimate */
+	float32_t Fs;             /*!< Decimated sample rate in Hz */
+	float32_t Rate;           /*!< Breaths per minute, 0 if unknown */
+	float32_t Quality;        /*!< Normalized autocorrelation at detected lag */
+	/* Scratch of estimate, kept off the 1 KB main stack shared with nested interrupts */
+	q15_t Linear[RESP_WINDOW];/*!< Window oldest first, mean removed */
+	float32_t Acf[RESP_WINDOW]; /*!< Normalized autocorrelation by lag */
+} RESP_t;
+
+/**
+ * @brief  Initializes respiration extractor
+ * @param  *r: Pointer to @ref RESP_t structure
+ * @param  fs: Input sample rate in Hz
+ * @retval Member of @ref RESP_Result_t enumeration
+ */
+RESP_Result_t RESP_Init(RESP_t* r, float32_t fs);
+
+/**
+ * @brief  Processes block of conditioned samples
+ * @param  *r: Pointer to @ref RESP_t structure
+ * @param  *x: Pointer to q15 samples at input rate
+ * @param  count: Number of samples, any length
+ * @retval 1 if new estimate was made, 0 otherwise
+ */
+uint8_t RESP_Process_q15(RESP_t* r, const q15_t* x, uint32_t count);
+
+/**
+ * @brief  Gets last respiration rate
+ * @param  *r: Pointer to @ref RESP_t structure
+ * @retval Breaths per minute, 0 if not known
+ */
+#define RESP_GetRate(r)				((r)->Rate)
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,98 @@
+#include "sigcond.h"
+
+/* Both halfword lanes set to 1, used for sum of two samples with dual multiply-add */
+#define SIGCOND_ONES			0x00010001UL
+
+/*
+ * Shifts two centered samples, already saturated to SIGCOND_ADC_BITS, to q15 with one word shift.
+ * Sign bits of low halfword which move to the high halfword are masked out.
+ */
+#define SIGCOND_SHIFT_PAIR(w)	(((uint32_t)(w) << SIGCOND_Q15_SHIFT) & ~(((1UL << SIGCOND_Q15_SHIFT) - 1) << 16))
+
+void SIGCOND_Init(SIGCOND_t* cond, uint16_t offset, q15_t scaleFract, int8_t shift) {
+	cond->ScaleFract = scaleFract;
+	cond->Shift = shift;
+	cond->Unity = (scaleFract == 0x4000 && shift == 1);
+	SIGCOND_SetOffset(cond, offset);
+}
+
+void SIGCOND_SetOffset(SIGCOND_t* cond, uint16_t offset) {
+	cond->OffsetPair = (uint32_t)offset | ((uint32_t)offset << 16);
+}
+
+void SIGCOND_Process(SIGCOND_t* cond, const uint16_t* raw, q15_t* out, uint32_t count, SIGCOND_Stats_t* stats) {
+	const q15_t* pIn = (const q15_t *)raw;
+	q15_t* pOut = out;
+	uint32_t off = cond->OffsetPair;
+	int32_t sum = stats->Sum;
+	uint64_t sumSq = (uint64_t)stats->SumSq;
+	uint32_t in1, in2, blk;
+
+	stats->Count += count;
+	blk = count >> 2;
+
+	if (cond->Unity) {
+		/* Offset and shift only, 4 samples per loop */
+		while (blk-- > 0) {
+			in1 = *__SIMD32(pIn)++;
+			in2 = *__SIMD32(pIn)++;
+			in1 = SIGCOND_SHIFT_PAIR(__SSAT16(__SSUB16(in1, off), SIGCOND_ADC_BITS));
+			in2 = SIGCOND_SHIFT_PAIR(__SSAT16(__SSUB16(in2, off), SIGCOND_ADC_BITS));
+			*__SIMD32(pOut)++ = in1;
+			*__SIMD32(pOut)++ = in2;
+			sum = __SMLAD(in1, SIGCOND_ONES, sum);
+			sum = __SMLAD(in2, SIGCOND_ONES, sum);
+			sumSq = __SMLALD(in1, in1, sumSq);
+			sumSq = __SMLALD(in2, in2, sumSq);
+		}
+		if (count & 0x02) {
+			in1 = *__SIMD32(pIn)++;
+			in1 = SIGCOND_SHIFT_PAIR(__SSAT16(__SSUB16(in1, off), SIGCOND_ADC_BITS));
+			*__SIMD32(pOut)++ = in1;
+			sum = __SMLAD(in1, SIGCOND_ONES, sum);
+			sumSq = __SMLALD(in1, in1, sumSq);
+		}
+	} else {
+		int32_t g = cond->ScaleFract;
+		int8_t s = 15 - cond->Shift;
+		q31_t lo, hi;
+
+		blk = count >> 1;
+		while (blk-- > 0) {
+			/* Difference of two unsigned ADC samples always fits to halfword */
+			in1 = __SSUB16(*__SIMD32(pIn)++, off);
+			lo = __SSAT((((q15_t)in1 << SIGCOND_Q15_SHIFT) * g) >> s, 16);
+			hi = __SSAT((((q15_t)(in1 >> 16) << SIGCOND_Q15_SHIFT) * g) >> s, 16);
+			in1 = __PKHBT(lo, hi, 16);
+			*__SIMD32(pOut)++ = in1;
+			sum = __SMLAD(in1, SIGCOND_ONES, sum);
+			sumSq = __SMLALD(in1, in1, sumSq);
+		}
+	}
+
+	stats->Sum = sum;
+	stats->SumSq = (int64_t)sumSq;
+}
+
+void SIGCOND_ResetStats(SIGCOND_Stats_t* stats) {
+	stats->Sum = 0;
+	stats->SumSq = 0;
+	stats->Count = 0;
+}
+
+q15_t SIGCOND_Mean(SIGCOND_Stats_t* stats) {
+	if (stats->Count == 0) {
+		return 0;
+	}
+	return (q15_t)(stats->Sum / (int32_t)stats->Count);
+}
+
+q31_t SIGCOND_Variance(SIGCOND_Stats_t* stats) {
+	int64_t mean;
+
+	if (stats->Count == 0) {
+		return 0;
+	}
+	mean = stats->Sum / (int32_t)stats->Count;
+	return (q31_t)(stats->SumSq / stats->Count - mean * mean);
+}
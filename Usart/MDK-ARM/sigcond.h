@@ -0,0 +1,100 @@
+#ifndef SIGCOND_H
+#define SIGCOND_H 100
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Single pass conditioning of raw 12-bit right aligned ADC halfwords to q15:
+ *
+ *  - DC offset removal
+ *  - Shift to q15 full scale (12-bit sample << 4)
+ *  - Gain, same meaning as in arm_scale_q15 (scaleFract * 2^shift)
+ *  - Block sum and sum of squares of output samples
+ *
+ * Samples are read and written two per 32-bit access.
+ */
+
+#include "stm32f4xx_hal.h"
+#include "arm_math.h"
+
+/* ADC resolution in bits */
+#ifndef SIGCOND_ADC_BITS
+#define SIGCOND_ADC_BITS			12
+#endif
+
+/* Shift from ADC resolution to q15 */
+#define SIGCOND_Q15_SHIFT			(16 - SIGCOND_ADC_BITS)
+
+typedef struct {
+	uint32_t OffsetPair;  /*!< DC offset in raw ADC units, packed twice */
+	q15_t ScaleFract;     /*!< Fractional part of gain */
+	int8_t Shift;         /*!< Number of bits to shift gain */
+	uint8_t Unity;        /*!< Set to 1 if gain is exactly 1.0, multiply is skipped */
+} SIGCOND_t;
+
+typedef struct {
+	int32_t Sum;          /*!< Sum of output samples */
+	int64_t SumSq;        /*!< Sum of squared output samples */
+	uint32_t Count;       /*!< Number of samples accumulated */
+} SIGCOND_Stats_t;
+
+/**
+ * @brief  Initializes conditioning structure
+ * @param  *cond: Pointer to @ref SIGCOND_t structure
+ * @param  offset: DC offset in raw ADC units, for example 2048 for mid-scale
+ * @param  scaleFract: Fractional gain, as in arm_scale_q15
+ * @param  shift: Gain shift, as in arm_scale_q15
+ * @note   Gain of exactly 1.0 (scaleFract = 0x4000, shift = 1) takes faster path without multiply
+ * @retval None
+ */
+void SIGCOND_Init(SIGCOND_t* cond, uint16_t offset, q15_t scaleFract, int8_t shift);
+
+/**
+ * @brief  Sets new DC offset
+ * @param  *cond: Pointer to @ref SIGCOND_t structure
+ * @param  offset: DC offset in raw ADC units
+ * @retval None
+ */
+void SIGCOND_SetOffset(SIGCOND_t* cond, uint16_t offset);
+
+/**
+ * @brief  Converts raw ADC samples to conditioned q15 samples in one pass
+ * @param  *cond: Pointer to @ref SIGCOND_t structure
+ * @param  *raw: Pointer to raw ADC halfwords, for example DMA half-block
+ * @param  *out: Pointer to output q15 samples, can be the same as raw
+ * @param  count: Number of samples, must be even
+ * @param  *stats: Pointer to @ref SIGCOND_Stats_t where sums are accumulated. Use @ref SIGCOND_ResetStats() before new block
+ * @retval None
+ */
+void SIGCOND_Process(SIGCOND_t* cond, const uint16_t* raw, q15_t* out, uint32_t count, SIGCOND_Stats_t* stats);
+
+/**
+ * @brief  Resets statistics accumulators
+ * @param  *stats: Pointer to @ref SIGCOND_Stats_t structure
+ * @retval None
+ */
+void SIGCOND_ResetStats(SIGCOND_Stats_t* stats);
+
+/**
+ * @brief  Gets mean of accumulated samples
+ * @param  *stats: Pointer to @ref SIGCOND_Stats_t structure
+ * @retval Mean in q15
+ */
+q15_t SIGCOND_Mean(SIGCOND_Stats_t* stats);
+
+/**
+ * @brief  Gets variance of accumulated samples
+ * @param  *stats: Pointer to @ref SIGCOND_Stats_t structure
+ * @retval Variance in q15 squared units (q30)
+ */
+q31_t SIGCOND_Variance(SIGCOND_Stats_t* stats);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,56 @@
+#include "smat.h"
+
+/* Symmetric positive definite test matrix */
+static const float32_t SMAT_TestA[16] = {
+	4.0f, 1.0f, 0.5f, 0.2f,
+	1.0f, 3.0f, 0.3f, 0.1f,
+	0.5f, 0.3f, 2.0f, 0.4f,
+	0.2f, 0.1f, 0.4f, 1.5f
+};
+
+void SMAT_Benchmark(SMAT_Benchmark_t* result) {
+	static float32_t a[16], b[16], c[16];
+	static float32_t a6[36], b6[36], c6[36];
+	arm_matrix_instance_f32 ia, ib, ic;
+	uint32_t start, i;
+
+	for (i = 0; i < 36; i++) {
+		a6[i] = (float32_t)i * 0.1f;
+		b6[i] = 1.0f - (float32_t)i * 0.05f;
+	}
+	memcpy(b, SMAT_TestA, sizeof(b));
+
+	/* 4x4 multiply */
+	memcpy(a, SMAT_TestA, sizeof(a));
+	SMAT_Instance(&ia, 4, 4, a);
+	SMAT_Instance(&ib, 4, 4, b);
+	SMAT_Instance(&ic, 4, 4, c);
+	start = DWT->CYCCNT;
+	arm_mat_mult_f32(&ia, &ib, &ic);
+	result->MultGeneric = DWT->CYCCNT - start;
+
+	start = DWT->CYCCNT;
+	SMAT_Mult_4x4x4(a, b, c);
+	result->MultFixed = DWT->CYCCNT - start;
+
+	/* 4x4 inverse, CMSIS function destroys source matrix */
+	start = DWT->CYCCNT;
+	arm_mat_inverse_f32(&ia, &ic);
+	result->InvGeneric = DWT->CYCCNT - start;
+
+	start = DWT->CYCCNT;
+	SMAT_InvSPD_4x4(b, c);
+	result->InvFixed = DWT->CYCCNT - start;
+
+	/* 6x6 multiply */
+	SMAT_Instance(&ia, 6, 6, a6);
+	SMAT_Instance(&ib, 6, 6, b6);
+	SMAT_Instance(&ic, 6, 6, c6);
+	start = DWT->CYCCNT;
+	arm_mat_mult_f32(&ia, &ib, &ic);
+	result->Mult6Generic = DWT->CYCCNT - start;
+
+	start = DWT->CYCCNT;
+	SMAT_Mult_6x6x6(a6, b6, c6);
+	result->Mult6Fixed = DWT->CYCCNT - start;
+}
@@ -0,0 +1,220 @@
+#ifndef SMAT_H
+#define SMAT_H 100
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Small fixed-size float matrix kernels.
+ *
+ * Dimensions are part of function name and loop bounds are constants,
+ * so compiler fully unrolls loops and there are no run-time size checks.
+ * Matrices are row-major float32_t arrays, exactly as pData of arm_matrix_instance_f32,
+ * so the same storage can be passed to arm_mat_* functions.
+ *
+ * Square sizes 2 to 6 are predefined, other shapes are created with SMAT_DEFINE_* macros:
+ *
+ *   SMAT_DEFINE_MULT(2, 6, 1)   ->   SMAT_Mult_2x6x1(a, b, c)    c[2x1] = a[2x6] * b[6x1]
+ */
+
+#include "stm32f4xx_hal.h"
+#include "arm_math.h"
+
+/**
+ * @brief  Initializes arm_matrix_instance_f32 over existing SMAT storage
+ * @param  inst: Pointer to arm_matrix_instance_f32
+ * @param  rows: Number of rows
+ * @param  cols: Number of columns
+ * @param  data: Pointer to row-major data
+ */
+#define SMAT_Instance(inst, rows, cols, data)	arm_mat_init_f32((inst), (rows), (cols), (float32_t *)(data))
+
+/* c[MxP] = a[MxN] * b[NxP] */
+#define SMAT_DEFINE_MULT(M, N, P)                                                                               \
+static __INLINE void SMAT_Mult_##M##x##N##x##P(const float32_t* a, const float32_t* b, float32_t* c) {          \
+	uint32_t i, j, k;                                                                                           \
+	for (i = 0; i < (M); i++) {                                                                                 \
+		for (j = 0; j < (P); j++) {                                                                             \
+			float32_t s = 0.0f;                                                                                 \
+			for (k = 0; k < (N); k++) {                                                                         \
+				s += a[i * (N) + k] * b[k * (P) + j];                                                           \
+			}                                                                                                   \
+			c[i * (P) + j] = s;                                                                                 \
+		}                                                                                                       \
+	}                                                                                                           \
+}
+
+/* c[MxP] = a[MxN] * b[PxN]^T */
+#define SMAT_DEFINE_MULT_TRANS(M, N, P)                                                                         \
+static __INLINE void SMAT_MultTrans_##M##x##N##x##P(const float32_t* a, const float32_t* b, float32_t* c) {     \
+	uint32_t i, j, k;                                                                                           \
+	for (i = 0; i < (M); i++) {                                                                                 \
+		for (j = 0; j < (P); j++) {                                                                             \
+			float32_t s = 0.0f;                                                                                 \
+			for (k = 0; k < (N); k++) {                                                                         \
+				s += a[i * (N) + k] * b[j * (N) + k];                                                           \
+			}                                                                                                   \
+			c[i * (P) + j] = s;                                                                                 \
+		}                                                                                                       \
+	}                                                                                                           \
+}
+
+/* b[NxM] = a[MxN]^T */
+#define SMAT_DEFINE_TRANS(M, N)                                                                                 \
+static __INLINE void SMAT_Trans_##M##x##N(const float32_t* a, float32_t* b) {                                   \
+	uint32_t i, j;                                                                                              \
+	for (i = 0; i < (M); i++) {                                                                                 \
+		for (j = 0; j < (N); j++) {                                                                             \
+			b[j * (M) + i] = a[i * (N) + j];                                                                    \
+		}                                                                                                       \
+	}                                                                                                           \
+}
+
+/* c = a + b, c = a - b, c = a * k, all MxN */
+#define SMAT_DEFINE_ADD(M, N)                                                                                   \
+static __INLINE void SMAT_Add_##M##x##N(const float32_t* a, const float32_t* b, float32_t* c) {                 \
+	uint32_t i;                                                                                                 \
+	for (i = 0; i < (M) * (N); i++) {                                                                           \
+		c[i] = a[i] + b[i];                                                                                     \
+	}                                                                                                           \
+}                                                                                                               \
+static __INLINE void SMAT_Sub_##M##x##N(const float32_t* a, const float32_t* b, float32_t* c) {                 \
+	uint32_t i;                                                                                                 \
+	for (i = 0; i < (M) * (N); i++) {                                                                           \
+		c[i] = a[i] - b[i];                                                                                     \
+	}                                                                                                           \
+}                                                                                                               \
+static __INLINE void SMAT_Scale_##M##x##N(const float32_t* a, float32_t k, float32_t* c) {                      \
+	uint32_t i;                                                                                                 \
+	for (i = 0; i < (M) * (N); i++) {                                                                           \
+		c[i] = a[i] * k;                                                                                        \
+	}                                                                                                           \
+}
+
+/*
+ * Cholesky decomposition a = l * l^T of symmetric positive definite NxN matrix.
+ * Only lower triangle of a is read, upper triangle of l is cleared.
+ * Returns 0 if matrix is not positive definite.
+ */
+#define SMAT_DEFINE_CHOL(N)                                                                                     \
+static __INLINE uint8_t SMAT_Chol_##N##x##N(const float32_t* a, float32_t* l) {                                 \
+	uint32_t i, j, k;                                                                                           \
+	for (i = 0; i < (N); i++) {                                                                                 \
+		for (j = 0; j <= i; j++) {                                                                              \
+			float32_t s = a[i * (N) + j];                                                                       \
+			for (k = 0; k < j; k++) {                                                                           \
+				s -= l[i * (N) + k] * l[j * (N) + k];                                                           \
+			}                                                                                                   \
+			if (i == j) {                                                                                       \
+				if (s <= 0.0f) {                                                                                \
+					return 0;                                                                                   \
+				}                                                                                               \
+				arm_sqrt_f32(s, &l[i * (N) + i]);                                                               \
+			} else {                                                                                            \
+				l[i * (N) + j] = s / l[j * (N) + j];                                                            \
+			}                                                                                                   \
+		}                                                                                                       \
+		for (j = i + 1; j < (N); j++) {                                                                         \
+			l[i * (N) + j] = 0.0f;                                                                              \
+		}                                                                                                       \
+	}                                                                                                           \
+	return 1;                                                                                                   \
+}
+
+/*
+ * Inverse of symmetric positive definite NxN matrix through Cholesky decomposition.
+ * Returns 0 if matrix is not positive definite, a and inv can not be the same.
+ */
+#define SMAT_DEFINE_INV_SPD(N)                                                                                  \
+static __INLINE uint8_t SMAT_InvSPD_##N##x##N(const float32_t* a, float32_t* inv) {                             \
+	float32_t l[(N) * (N)], li[(N) * (N)];                                                                      \
+	uint32_t i, j, k;                                                                                           \
+	if (!SMAT_Chol_##N##x##N(a, l)) {                                                                           \
+		return 0;                                                                                               \
+	}                                                                                                           \
+	/* li = l^-1, lower triangular */                                                                           \
+	for (j = 0; j < (N); j++) {                                                                                 \
+		li[j * (N) + j] = 1.0f / l[j * (N) + j];                                                                \
+		for (i = j + 1; i < (N); i++) {                                                                         \
+			float32_t s = 0.0f;                                                                                 \
+			for (k = j; k < i; k++) {                                                                           \
+				s -= l[i * (N) + k] * li[k * (N) + j];                                                          \
+			}                                                                                                   \
+			li[i * (N) + j] = s / l[i * (N) + i];                                                               \
+		}                                                                                                       \
+	}                                                                                                           \
+	/* inv = li^T * li, symmetric */                                                                            \
+	for (i = 0; i < (N); i++) {                                                                                 \
+		for (j = 0; j <= i; j++) {                                                                              \
+			float32_t s = 0.0f;                                                                                 \
+			for (k = i; k < (N); k++) {                                                                         \
+				s += li[k * (N) + i] * li[k * (N) + j];                                                         \
+			}                                                                                                   \
+			inv[i * (N) + j] = s;                                                                               \
+			inv[j * (N) + i] = s;                                                                               \
+		}                                                                                                       \
+	}                                                                                                           \
+	return 1;                                                                                                   \
+}
+
+/* All square operations for size N */
+#define SMAT_DEFINE_SQUARE(N)                                                                                   \
+	SMAT_DEFINE_MULT(N, N, N)                                                                                   \
+	SMAT_DEFINE_MULT_TRANS(N, N, N)                                                                             \
+	SMAT_DEFINE_TRANS(N, N)                                                                                     \
+	SMAT_DEFINE_ADD(N, N)                                                                                       \
+	SMAT_DEFINE_CHOL(N)                                                                                         \
+	SMAT_DEFINE_INV_SPD(N)
+
+SMAT_DEFINE_SQUARE(2)
+SMAT_DEFINE_SQUARE(3)
+SMAT_DEFINE_SQUARE(4)
+SMAT_DEFINE_SQUARE(5)
+SMAT_DEFINE_SQUARE(6)
+
+/**
+ * @brief  Inverse of general 2x2 matrix in closed form
+ * @param  *a: Pointer to 2x2 matrix
+ * @param  *inv: Pointer to 2x2 result, can be the same as a
+ * @retval 0 if matrix is singular, 1 otherwise
+ */
+static __INLINE uint8_t SMAT_Inv_2x2(const float32_t* a, float32_t* inv) {
+	float32_t det = a[0] * a[3] - a[1] * a[2];
+	float32_t a0 = a[0];
+
+	if (det == 0.0f) {
+		return 0;
+	}
+	det = 1.0f / det;
+	inv[0] = a[3] * det;
+	inv[1] = -a[1] * det;
+	inv[2] = -a[2] * det;
+	inv[3] = a0 * det;
+	return 1;
+}
+
+typedef struct {
+	uint32_t MultGeneric;    /*!< Cycles of arm_mat_mult_f32, 4x4 */
+	uint32_t MultFixed;      /*!< Cycles of SMAT_Mult_4x4x4 */
+	uint32_t InvGeneric;     /*!< Cycles of arm_mat_inverse_f32, 4x4 */
+	uint32_t InvFixed;       /*!< Cycles of SMAT_InvSPD_4x4 */
+	uint32_t Mult6Generic;   /*!< Cycles of arm_mat_mult_f32, 6x6 */
+	uint32_t Mult6Fixed;     /*!< Cycles of SMAT_Mult_6x6x6 */
+} SMAT_Benchmark_t;
+
+/**
+ * @brief  Measures fixed-size kernels against generic CMSIS matrix functions
+ * @note   DWT cycle counter must be running, use @ref DELAY_Init() first
+ * @param  *result: Pointer to @ref SMAT_Benchmark_t where cycle counts are saved
+ * @retval None
+ */
+void SMAT_Benchmark(SMAT_Benchmark_t* result);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,99 @@
+#include "sqi.h"
+
+uint8_t SQI_Assess_q15(const q15_t* x, uint32_t count, SIGCOND_Stats_t* stats, SQI_t* q) {
+	q15_t mean = SIGCOND_Mean(stats);
+	q31_t variance = SIGCOND_Variance(stats);
+	float32_t d, d2, m4 = 0.0f, band = 0.0f;
+	uint32_t clipped = 0, run = 0, maxRun = 0, seg, i;
+	int32_t segSum;
+	q15_t prev = x[0];
+
+	for (seg = 0; seg < count; seg += SQI_SEGMENT) {
+		segSum = 0;
+		for (i = seg; i < seg + SQI_SEGMENT; i++) {
+			q15_t v = x[i];
+
+			segSum += v;
+			if (v >= SQI_CLIP_LEVEL || v <= -SQI_CLIP_LEVEL) {
+				clipped++;
+			}
+			if (v == prev) {
+				run++;
+			} else {
+				if (run > maxRun) {
+					maxRun = run;
+				}
+				run = 1;
+				prev = v;
+			}
+
+			/* Fourth central moment */
+			d = (float32_t)(v - mean);
+			d2 = d * d;
+			m4 += d2 * d2;
+		}
+
+		/* Power of segment means */
+		d = (float32_t)segSum / SQI_SEGMENT - mean;
+		band += d * d;
+	}
+	if (run > maxRun) {
+		maxRun = run;
+	}
+
+	q->Clipped = (uint16_t)clipped;
+	q->FlatRun = (uint16_t)maxRun;
+	q->Flags = 0;
+
+	if (variance < SQI_FLAT_VARIANCE) {
+		q->Kurtosis = 0.0f;
+		q->BandRatio = 0.0f;
+		q->Flags |= SQI_Flag_Flat;
+	} else {
+		d = (float32_t)variance;
+		q->Kurtosis = m4 / count / (d * d);
+		q->BandRatio = band * SQI_SEGMENT / count / d;
+	}
+
+	if (maxRun >= SQI_FLAT_RUN) {
+		q->Flags |= SQI_Flag_Flat;
+	}
+	if (clipped > (count >> SQI_CLIP_SHIFT)) {
+		q->Flags |= SQI_Flag_Clipped;
+	}
+	if (q->Kurtosis > SQI_KURTOSIS_MAX) {
+		q->Flags |= SQI_Flag_Spiky;
+	}
+	if (q->BandRatio < SQI_BAND_MIN && !(q->Flags & SQI_Flag_Flat)) {
+		q->Flags |= SQI_Flag_Noisy;
+	}
+
+	/* Score from in-band share, reduced by clipping and excess kurtosis */
+	d = q->BandRatio > 1.0f ? 1.0f : q->BandRatio;
+	d *= 1.0f - (float32_t)clipped / count;
+	if (q->Kurtosis > 3.0f) {
+		d *= 3.0f / q->Kurtosis;
+	}
+	q->Score = (uint8_t)(d * 100.0f);
+	if (q->Score < SQI_SCORE_MIN) {
+		/* Every bad block has reason, so marker is sent for it */
+		q->Flags |= SQI_Flag_LowScore;
+	}
+
+	return SQI_IsGood(q);
+}
+
+void SQI_Pack(const SQI_t* q, uint8_t* data) {
+	uint16_t kurtosis = (uint16_t)__USAT((int32_t)(q->Kurtosis * 10.0f), 16);
+
+	data[0] = 'Q';
+	data[1] = q->Flags;
+	data[2] = q->Score;
+	data[3] = (uint8_t)q->Clipped;
+	data[4] = (uint8_t)(q->Clipped >> 8);
+	data[5] = (uint8_t)q->FlatRun;
+	data[6] = (uint8_t)(q->FlatRun >> 8);
+	data[7] = (uint8_t)kurtosis;
+	data[8] = (uint8_t)(kurtosis >> 8);
+	data[9] = (uint8_t)__USAT((int32_t)(q->BandRatio * 100.0f), 8);
+}
@@ -0,0 +1,92 @@
+#ifndef SQI_H
+#define SQI_H 100
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Signal quality index of conditioned optical block.
+ *
+ * Block is checked in one pass for:
+ *  - clipping: samples at ADC rails
+ *  - flatline: long run of equal samples or almost no variance (sensor off skin)
+ *  - kurtosis: spikes from contact loss or electrical interference
+ *  - in-band power ratio: variance of segment means against total variance,
+ *    segment means keep pulse wave and drop high frequency noise
+ *
+ * Mean and variance are taken from @ref SIGCOND_Stats_t, accumulated during conditioning.
+ * Blocks which are not good should skip motion compensation and HRV stages.
+ */
+
+#include "stm32f4xx_hal.h"
+#include "arm_math.h"
+#include "sigcond.h"
+
+/* Samples with absolute value at least this are clipped */
+#define SQI_CLIP_LEVEL				32000
+/* Maximal share of clipped samples as shift, 1/128 of block */
+#define SQI_CLIP_SHIFT				7
+/* Run of equal samples which means flatline */
+#define SQI_FLAT_RUN				64
+/* Variance in q30 below which block is flat, deviation of 4 LSB of 12-bit ADC */
+#define SQI_FLAT_VARIANCE			(64 * 64)
+/* Maximal kurtosis, sine is 1.5 and gaussian noise 3 */
+#define SQI_KURTOSIS_MAX			8.0f
+/* Length of segment for in-band power, 32 samples at 1920 Hz pass below 30 Hz */
+#define SQI_SEGMENT					32
+/* Minimal in-band power ratio */
+#define SQI_BAND_MIN				0.5f
+/* Minimal score of good block */
+#define SQI_SCORE_MIN				40
+
+typedef enum {
+	SQI_Flag_Clipped = 0x01,  /*!< Too many samples at ADC rails */
+	SQI_Flag_Flat = 0x02,     /*!< Flatline, no signal */
+	SQI_Flag_Spiky = 0x04,    /*!< Kurtosis too high */
+	SQI_Flag_Noisy = 0x08,    /*!< Too much power out of band */
+	SQI_Flag_LowScore = 0x10  /*!< Score below SQI_SCORE_MIN without other reason */
+} SQI_Flag_t;
+
+typedef struct {
+	uint8_t Score;            /*!< Quality from 0 to 100 */
+	uint8_t Flags;            /*!< Reasons of bad quality, OR-ed @ref SQI_Flag_t values */
+	uint16_t Clipped;         /*!< Number of clipped samples */
+	uint16_t FlatRun;         /*!< Longest run of equal samples */
+	float32_t Kurtosis;       /*!< Fourth standardized moment */
+	float32_t BandRatio;      /*!< In-band to total power ratio */
+} SQI_t;
+
+/**
+ * @brief  Computes signal quality of block
+ * @param  *x: Pointer to conditioned q15 samples
+ * @param  count: Number of samples, multiple of @ref SQI_SEGMENT
+ * @param  *stats: Pointer to @ref SIGCOND_Stats_t accumulated over the same samples
+ * @param  *q: Pointer to @ref SQI_t structure to store result to
+ * @retval 1 if block is good, 0 otherwise
+ */
+uint8_t SQI_Assess_q15(const q15_t* x, uint32_t count, SIGCOND_Stats_t* stats, SQI_t* q);
+
+/**
+ * @brief  Checks if result is good
+ * @param  *q: Pointer to @ref SQI_t structure
+ * @retval 1 if good, 0 otherwise
+ */
+#define SQI_IsGood(q)				((q)->Flags == 0 && (q)->Score >= SQI_SCORE_MIN)
+
+/**
+ * @brief  Packs bad signal marker to 10 bytes for transmission
+ * @note   Layout: 'Q', flags, score, clipped (LE), flat run (LE), kurtosis x10 (LE), band ratio x100
+ * @param  *q: Pointer to @ref SQI_t structure
+ * @param  *data: Pointer to 10 bytes output buffer
+ * @retval None
+ */
+void SQI_Pack(const SQI_t* q, uint8_t* data);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
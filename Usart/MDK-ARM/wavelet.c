@@ -0,0 +1,258 @@
+#include "wavelet.h"
+
+/* Daubechies-4 lifting coefficients, Q14 */
+#define WAVELET_D4_SQRT3				28378		// sqrt(3)
+#define WAVELET_D4_U0					7094		// sqrt(3) / 4
+#define WAVELET_D4_U1					(-1098)		// (sqrt(3) - 2) / 4
+#define WAVELET_D4_ROUND				(1 << 13)
+
+/* Packed (U0, U1) pair for dual multiply with (s[k], s[k-1]) */
+#define WAVELET_D4_UPDATE_PAIR			(((uint32_t)WAVELET_D4_U0 & 0xFFFF) | ((uint32_t)WAVELET_D4_U1 << 16))
+
+/* Rounding constant for two halfwords at a time */
+#define WAVELET_ONES					0x00010001UL
+
+/* Private functions */
+static void WAVELET_Forward53_Pairs(uint32_t* w, uint32_t pairs);
+static void WAVELET_Inverse53_Pairs(uint32_t* w, uint32_t pairs);
+static void WAVELET_Forward53_Stride(q15_t* x, uint32_t pairs, uint32_t stride);
+static void WAVELET_Inverse53_Stride(q15_t* x, uint32_t pairs, uint32_t stride);
+static void WAVELET_ForwardD4_Stride(q15_t* x, uint32_t pairs, uint32_t stride);
+static void WAVELET_InverseD4_Stride(q15_t* x, uint32_t pairs, uint32_t stride);
+static uint8_t WAVELET_CheckLength(uint32_t length, uint8_t levels);
+
+WAVELET_Result_t WAVELET_Forward_q15(q15_t* data, uint32_t length, uint8_t levels, WAVELET_Type_t type) {
+	uint8_t l;
+
+	if (!WAVELET_CheckLength(length, levels)) {
+		return WAVELET_Result_Error;
+	}
+
+	for (l = 0; l < levels; l++) {
+		uint32_t pairs = length >> (l + 1);
+
+		if (type == WAVELET_Type_LeGall53) {
+			if (l == 0) {
+				/* Neighbouring samples, two pairs per 32-bit word operation */
+				WAVELET_Forward53_Pairs((uint32_t *)data, pairs);
+			} else {
+				WAVELET_Forward53_Stride(data, pairs, 1UL << l);
+			}
+		} else {
+			WAVELET_ForwardD4_Stride(data, pairs, 1UL << l);
+		}
+	}
+
+	return WAVELET_Result_Ok;
+}
+
+WAVELET_Result_t WAVELET_Inverse_q15(q15_t* data, uint32_t length, uint8_t levels, WAVELET_Type_t type) {
+	uint8_t l;
+
+	if (!WAVELET_CheckLength(length, levels)) {
+		return WAVELET_Result_Error;
+	}
+
+	/* Coarsest level first */
+	for (l = levels; l-- > 0; ) {
+		uint32_t pairs = length >> (l + 1);
+
+		if (type == WAVELET_Type_LeGall53) {
+			if (l == 0) {
+				WAVELET_Inverse53_Pairs((uint32_t *)data, pairs);
+			} else {
+				WAVELET_Inverse53_Stride(data, pairs, 1UL << l);
+			}
+		} else {
+			WAVELET_InverseD4_Stride(data, pairs, 1UL << l);
+		}
+	}
+
+	return WAVELET_Result_Ok;
+}
+
+void WAVELET_Shrink_q15(q15_t* data, uint32_t length, uint8_t level, q15_t threshold) {
+	uint32_t i;
+
+	for (i = WAVELET_DETAIL_OFFSET(level); i < length; i += WAVELET_STRIDE(level)) {
+		if (data[i] > threshold) {
+			data[i] -= threshold;
+		} else if (data[i] < -threshold) {
+			data[i] += threshold;
+		} else {
+			data[i] = 0;
+		}
+	}
+}
+
+void WAVELET_ClearApprox_q15(q15_t* data, uint32_t length, uint8_t levels) {
+	uint32_t i;
+
+	for (i = 0; i < length; i += WAVELET_STRIDE(levels)) {
+		data[i] = 0;
+	}
+}
+
+static uint8_t WAVELET_CheckLength(uint32_t length, uint8_t levels) {
+	if (levels == 0 || levels > WAVELET_MAX_LEVELS) {
+		return 0;
+	}
+	/* Each level needs even number of samples */
+	if ((length & ((1UL << levels) - 1)) != 0 || (length >> levels) == 0) {
+		return 0;
+	}
+	return 1;
+}
+
+/*
+ * Le Gall 5/3, first level.
+ * Word k holds (e[k], o[k]) pair, low halfword is even sample.
+ *   predict: o[k] -= (e[k] + e[k+1]) >> 1,         e[P] = e[P-1]
+ *   update:  e[k] += (o[k-1] + o[k] + 2) >> 2,     o[-1] = o[0]
+ * Update rounding is done as two halving adds: ((a + b) >> 1 + 1) >> 1 == (a + b + 2) >> 2
+ */
+static void WAVELET_Forward53_Pairs(uint32_t* w, uint32_t pairs) {
+	q15_t* x = (q15_t *)w;
+	uint32_t a, b, z, D, S, U;
+	uint32_t k;
+
+	/* Predict, two odd samples per iteration */
+	for (k = 0; k + 2 < pairs; k += 2) {
+		a = w[k];
+		b = w[k + 1];
+		D = __SHADD16(__PKHBT(a, b, 16), __PKHBT(b, w[k + 2], 16));		// (e[k] + e[k+1]) >> 1, (e[k+1] + e[k+2]) >> 1
+		D = __SSUB16(__PKHTB(b, a, 16), D);								// o[k], o[k+1] minus prediction
+		w[k] = __PKHBT(a, D, 16);
+		w[k + 1] = __PKHBT(b, D, 0);
+	}
+	for (; k < pairs; k++) {
+		int32_t e1 = (k + 1 < pairs) ? x[2 * k + 2] : x[2 * k];
+		x[2 * k + 1] = (q15_t)(x[2 * k + 1] - ((x[2 * k] + e1) >> 1));
+	}
+
+	/* Update, two even samples per iteration */
+	z = w[0];
+	for (k = 0; k + 1 < pairs; k += 2) {
+		a = w[k];
+		b = w[k + 1];
+		U = __SHADD16(__PKHTB(a, z, 16), __PKHTB(b, a, 16));			// (o[k-1] + o[k]) >> 1, (o[k] + o[k+1]) >> 1
+		U = __SHADD16(U, WAVELET_ONES);
+		S = __SADD16(__PKHBT(a, b, 16), U);
+		w[k] = __PKHBT(S, a, 0);
+		w[k + 1] = __PKHTB(b, S, 16);
+		z = b;
+	}
+	if (k < pairs) {
+		int32_t d0 = (k > 0) ? x[2 * k - 1] : x[2 * k + 1];
+		x[2 * k] = (q15_t)(x[2 * k] + ((d0 + x[2 * k + 1] + 2) >> 2));
+	}
+}
+
+static void WAVELET_Inverse53_Pairs(uint32_t* w, uint32_t pairs) {
+	q15_t* x = (q15_t *)w;
+	uint32_t a, b, z, D, S, U;
+	uint32_t k;
+
+	/* Undo update, odd samples are untouched so order does not matter */
+	z = w[0];
+	for (k = 0; k + 1 < pairs; k += 2) {
+		a = w[k];
+		b = w[k + 1];
+		U = __SHADD16(__PKHTB(a, z, 16), __PKHTB(b, a, 16));
+		U = __SHADD16(U, WAVELET_ONES);
+		S = __SSUB16(__PKHBT(a, b, 16), U);
+		w[k] = __PKHBT(S, a, 0);
+		w[k + 1] = __PKHTB(b, S, 16);
+		z = b;
+	}
+	if (k < pairs) {
+		int32_t d0 = (k > 0) ? x[2 * k - 1] : x[2 * k + 1];
+		x[2 * k] = (q15_t)(x[2 * k] - ((d0 + x[2 * k + 1] + 2) >> 2));
+	}
+
+	/* Undo predict, even samples are restored now */
+	for (k = 0; k + 2 < pairs; k += 2) {
+		a = w[k];
+		b = w[k + 1];
+		D = __SHADD16(__PKHBT(a, b, 16), __PKHBT(b, w[k + 2], 16));
+		D = __SADD16(__PKHTB(b, a, 16), D);
+		w[k] = __PKHBT(a, D, 16);
+		w[k + 1] = __PKHBT(b, D, 0);
+	}
+	for (; k < pairs; k++) {
+		int32_t e1 = (k + 1 < pairs) ? x[2 * k + 2] : x[2 * k];
+		x[2 * k + 1] = (q15_t)(x[2 * k + 1] + ((x[2 * k] + e1) >> 1));
+	}
+}
+
+/* Le Gall 5/3 on samples which are "stride" apart, used for deeper levels */
+static void WAVELET_Forward53_Stride(q15_t* x, uint32_t pairs, uint32_t stride) {
+	uint32_t k, s2 = 2 * stride;
+	q15_t *e, *o;
+
+	for (k = 0, e = x, o = x + stride; k < pairs; k++, e += s2, o += s2) {
+		int32_t e1 = (k + 1 < pairs) ? e[s2] : e[0];
+		*o = (q15_t)(*o - ((*e + e1) >> 1));
+	}
+	for (k = 0, e = x, o = x + stride; k < pairs; k++, e += s2, o += s2) {
+		int32_t d0 = (k > 0) ? o[-(int32_t)s2] : o[0];
+		*e = (q15_t)(*e + ((d0 + *o + 2) >> 2));
+	}
+}
+
+static void WAVELET_Inverse53_Stride(q15_t* x, uint32_t pairs, uint32_t stride) {
+	uint32_t k, s2 = 2 * stride;
+	q15_t *e, *o;
+
+	for (k = 0, e = x, o = x + stride; k < pairs; k++, e += s2, o += s2) {
+		int32_t d0 = (k > 0) ? o[-(int32_t)s2] : o[0];
+		*e = (q15_t)(*e - ((d0 + *o + 2) >> 2));
+	}
+	for (k = 0, e = x, o = x + stride; k < pairs; k++, e += s2, o += s2) {
+		int32_t e1 = (k + 1 < pairs) ? e[s2] : e[0];
+		*o = (q15_t)(*o + ((*e + e1) >> 1));
+	}
+}
+
+/*
+ * Daubechies-4 integer lifting (Daubechies/Sweldens factorization):
+ *   s1[k] = e[k] + sqrt(3) * o[k]
+ *   d[k]  = o[k] - sqrt(3)/4 * s1[k] - (sqrt(3) - 2)/4 * s1[k-1],    s1[-1] = s1[0]
+ *   s[k]  = s1[k] - d[k+1],                                           d[P] = d[P-1]
+ * Two-tap step is one dual 16x16 multiply-add.
+ */
+static void WAVELET_ForwardD4_Stride(q15_t* x, uint32_t pairs, uint32_t stride) {
+	uint32_t k, s2 = 2 * stride;
+	q15_t *e, *o;
+
+	for (k = 0, e = x, o = x + stride; k < pairs; k++, e += s2, o += s2) {
+		*e = (q15_t)(*e + ((WAVELET_D4_SQRT3 * *o + WAVELET_D4_ROUND) >> 14));
+	}
+	for (k = 0, e = x, o = x + stride; k < pairs; k++, e += s2, o += s2) {
+		q15_t sp = (k > 0) ? e[-(int32_t)s2] : e[0];
+		int32_t p = (int32_t)__SMUAD(__PKHBT(*e, sp, 16), WAVELET_D4_UPDATE_PAIR);
+		*o = (q15_t)(*o - ((p + WAVELET_D4_ROUND) >> 14));
+	}
+	for (k = 0, e = x, o = x + stride; k < pairs; k++, e += s2, o += s2) {
+		q15_t dn = (k + 1 < pairs) ? o[s2] : o[0];
+		*e = (q15_t)(*e - dn);
+	}
+}
+
+static void WAVELET_InverseD4_Stride(q15_t* x, uint32_t pairs, uint32_t stride) {
+	uint32_t k, s2 = 2 * stride;
+	q15_t *e, *o;
+
+	for (k = 0, e = x, o = x + stride; k < pairs; k++, e += s2, o += s2) {
+		q15_t dn = (k + 1 < pairs) ? o[s2] : o[0];
+		*e = (q15_t)(*e + dn);
+	}
+	for (k = 0, e = x, o = x + stride; k < pairs; k++, e += s2, o += s2) {
+		q15_t sp = (k > 0) ? e[-(int32_t)s2] : e[0];
+		int32_t p = (int32_t)__SMUAD(__PKHBT(*e, sp, 16), WAVELET_D4_UPDATE_PAIR);
+		*o = (q15_t)(*o + ((p + WAVELET_D4_ROUND) >> 14));
+	}
+	for (k = 0, e = x, o = x + stride; k < pairs; k++, e += s2, o += s2) {
+		*e = (q15_t)(*e - ((WAVELET_D4_SQRT3 * *o + WAVELET_D4_ROUND) >> 14));
+	}
+}
@@ -0,0 +1,100 @@
+#ifndef WAVELET_H
+#define WAVELET_H 100
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Integer lifting discrete wavelet transform on q15 blocks.
+ *
+ * Transform is done in place, coefficients stay interleaved ("in-place lifting" layout):
+ *
+ *  - Level L detail coefficients are at indexes (2^(L-1)) + k * 2^L
+ *  - Approximation of the last level is at indexes k * 2^levels
+ *
+ * All lifting steps use 16-bit wrap-around arithmetic, so inverse transform restores
+ * input bit-exact for any input. Coefficient values are meaningful only when input has headroom,
+ * 12-bit right aligned ADC samples can be passed as they are.
+ */
+
+#include "stm32f4xx_hal.h"
+#include "arm_math.h"
+
+/* Maximal number of decomposition levels */
+#ifndef WAVELET_MAX_LEVELS
+#define WAVELET_MAX_LEVELS			8
+#endif
+
+typedef enum {
+	WAVELET_Result_Ok = 0x00, /*!< Everything ok */
+	WAVELET_Result_Error      /*!< Length is not a multiple of 2^levels or levels out of range */
+} WAVELET_Result_t;
+
+typedef enum {
+	WAVELET_Type_LeGall53 = 0x00, /*!< Le Gall 5/3 (reversible JPEG2000 wavelet) */
+	WAVELET_Type_Daub4            /*!< Daubechies-4, integer lifting without final scaling step */
+} WAVELET_Type_t;
+
+/**
+ * @brief  Gets index of first detail coefficient for specific level
+ * @param  level: Decomposition level, from 1
+ * @retval Index of first coefficient, next one is at +WAVELET_STRIDE(level)
+ */
+#define WAVELET_DETAIL_OFFSET(level)		(1UL << ((level) - 1))
+
+/**
+ * @brief  Gets distance between two coefficients of the same band
+ * @param  level: Decomposition level, from 1
+ * @retval Distance between coefficients
+ */
+#define WAVELET_STRIDE(level)				(1UL << (level))
+
+/**
+ * @brief  Multi-level forward wavelet transform
+ * @note   Works in place, it can be called directly on DMA half-block which is not being written
+ * @param  *data: Pointer to q15 samples, must be 32-bit aligned
+ * @param  length: Number of samples, must be a multiple of 2^levels and at least 2^levels
+ * @param  levels: Number of decomposition levels, from 1 to @ref WAVELET_MAX_LEVELS
+ * @param  type: Wavelet type. This parameter can be a value of @ref WAVELET_Type_t enumeration
+ * @retval Member of @ref WAVELET_Result_t
+ */
+WAVELET_Result_t WAVELET_Forward_q15(q15_t* data, uint32_t length, uint8_t levels, WAVELET_Type_t type);
+
+/**
+ * @brief  Multi-level inverse wavelet transform
+ * @note   Parameters must be the same as used for @ref WAVELET_Forward_q15()
+ * @param  *data: Pointer to interleaved q15 coefficients, must be 32-bit aligned
+ * @param  length: Number of coefficients
+ * @param  levels: Number of decomposition levels
+ * @param  type: Wavelet type. This parameter can be a value of @ref WAVELET_Type_t enumeration
+ * @retval Member of @ref WAVELET_Result_t
+ */
+WAVELET_Result_t WAVELET_Inverse_q15(q15_t* data, uint32_t length, uint8_t levels, WAVELET_Type_t type);
+
+/**
+ * @brief  Soft thresholds detail coefficients of one level, used for denoising
+ * @param  *data: Pointer to interleaved q15 coefficients
+ * @param  length: Number of coefficients
+ * @param  level: Detail level to shrink, from 1
+ * @param  threshold: Coefficients with smaller magnitude are zeroed, others are moved toward zero by threshold
+ * @retval None
+ */
+void WAVELET_Shrink_q15(q15_t* data, uint32_t length, uint8_t level, q15_t threshold);
+
+/**
+ * @brief  Clears approximation coefficients of the last level, used for baseline removal
+ * @param  *data: Pointer to interleaved q15 coefficients
+ * @param  length: Number of coefficients
+ * @param  levels: Number of decomposition levels used for forward transform
+ * @retval None
+ */
+void WAVELET_ClearApprox_q15(q15_t* data, uint32_t length, uint8_t levels);
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -48,6 +48,19 @@
 #include "exti.h"
 #include "delay.h"
 #include "attributes.h"
+#include "sigcond.h"
+#include "lis3dsh.h"
+#include "fusion.h"
+#include "hrv.h"
+#include "resample.h"
+#include "sqi.h"
+#include "resp.h"
+#include "dtw.h"
+#include "pedo.h"
+#include "fall.h"
+#include "prof.h"
+#include "hop.h"
+#include "link.h"
 /* USER CODE END Includes */
 
 /* Private variables ---------------------------------------------------------*/
@@ -55,6 +68,25 @@
 /* USER CODE BEGIN PV */
 /* Private variables ---------------------------------------------------------*/
 
+/* ADC DMA circular buffer, processed in halves */
+#define ADC_BUFFER_SIZE		1024
+#define ADC_BLOCK_SIZE		(ADC_BUFFER_SIZE / 2)
+
+/* ADC sampling rate set by TIM2, 84 MHz / 43750 */
+#define ADC_SAMPLE_RATE		1920
+
+/* Accelerometer output data rate set in LIS3DSH_Init */
+#define ACC_SAMPLE_RATE		100
+
+/* Accelerometer is resampled from 100 Hz to fusion rate 120 Hz */
+#define ACC_RESAMPLE_L		6
+#define ACC_RESAMPLE_M		5
+#define ACC_RESAMPLE_TAPS	48
+#define ACC_COMMON_MAX		(LIS3DSH_FIFO_SIZE * ACC_RESAMPLE_L / ACC_RESAMPLE_M + 1)
+
+/* Radio channel at startup, link may hop to cleaner channel later */
+#define RADIO_CHANNEL		15
+
 /* Receiver address */
 uint8_t MyAddress[] = {
 	0xE7,
@@ -77,7 +109,61 @@ uint8_t dataOut[10], dataIn[10];
 char str[15];
 NRF24L01_Transmit_Status_t transmissionStatus;
 uint16_t data_frames = 3;
-__IO uint16_t ADC_value[1024];
+__IO uint16_t ADC_value[ADC_BUFFER_SIZE];
+
+/* Conditioned copy of last completed DMA half-block */
+q15_t ADC_block[ADC_BLOCK_SIZE];
+SIGCOND_t ADC_cond;
+SIGCOND_Stats_t ADC_stats;
+
+/* Quality of last block, marker is sent once when bad signal reason changes */
+SQI_t Sqi;
+uint8_t SqiReported;
+uint8_t SqiPending;
+
+/* Half-block ready for processing, set from DMA callbacks */
+__IO uint16_t* volatile ADC_ready = NULL;
+
+/* Accelerometer samples collected during last block */
+LIS3DSH_Axes_t ACC_fifo[LIS3DSH_FIFO_SIZE];
+uint8_t ACC_count;
+
+/* Accelerometer samples at fusion rate, one resampler per axis with shared filter */
+RESAMPLE_t ACC_resample[3];
+q15_t ACC_coeffs[ACC_RESAMPLE_TAPS];
+q15_t ACC_branches[ACC_RESAMPLE_TAPS];
+q15_t ACC_state[3][ACC_RESAMPLE_TAPS / ACC_RESAMPLE_L + LIS3DSH_FIFO_SIZE - 1];
+LIS3DSH_Axes_t ACC_common[ACC_COMMON_MAX];
+uint32_t ACC_commonCount;
+
+/* Motion compensated optical signal, one sample per filter step */
+FUSION_t Fusion;
+q15_t FUSION_out[ADC_BLOCK_SIZE / FUSION_DECIMATION];
+
+/* Heart rate variability, summary is sent once per minute */
+HRV_t Hrv;
+HRV_Summary_t HrvSummary;
+
+/* Respiration rate from baseline of conditioned signal */
+RESP_t Resp;
+
+/* Wrist gestures from accelerometer stream, last recognized one waits for transmission */
+DTW_t Gesture;
+int16_t GestureId = DTW_NONE;
+
+/* Steps and activity level, summary is sent once per minute */
+PEDO_t Pedo;
+PEDO_Summary_t PedoSummary;
+
+/* Fall detection runs in accelerometer interrupt, alert is sent before anything else */
+FALL_t Fall;
+
+/* Channel scan and hop, gateway follows 'C' packets */
+HOP_t Hop;
+
+/* Data rate, output power and retransmission follow link quality, gateway follows 'R' packets */
+LINK_t Link;
+LINK_Summary_t LinkSummary;
 
 /* USER CODE END PV */
 
@@ -86,6 +172,7 @@ void SystemClock_Config(void);
 
 /* USER CODE BEGIN PFP */
 /* Private function prototypes -----------------------------------------------*/
+uint32_t ACC_Resample(const LIS3DSH_Axes_t* in, uint32_t count, LIS3DSH_Axes_t* out);
 
 /* USER CODE END PFP */
 
@@ -97,6 +184,9 @@ int main(void)
 {
 
   /* USER CODE BEGIN 1 */
+	uint32_t i, start;
+	int16_t gesture;
+	uint8_t events;
   /* USER CODE END 1 */
 
   /* MCU Configuration----------------------------------------------------------*/
@@ -118,13 +208,39 @@ int main(void)
   /* USER CODE BEGIN 2 */
 	RCC_InitSystem();
 	DISCO_LedInit();
+	PROF_Init();
 	
-	NRF24L01_Init(15, 10);
-	NRF24L01_SetRF(NRF24L01_DataRate_250k, NRF24L01_OutputPower_0dBm);
+	NRF24L01_Init(RADIO_CHANNEL, 10);
 	NRF24L01_SetMyAddress(MyAddress);
 	NRF24L01_SetTxAddress(TxAddress);
+	HOP_Init(&Hop, RADIO_CHANNEL);
+	/* Start at 250kbps and 0dBm, gateway starts with the same */
+	LINK_Init(&Link, LINK_PROFILES - 1);
+	
+	/* Mid-scale offset, unity gain */
+	SIGCOND_Init(&ADC_cond, 2048, 0x4000, 1);
+	
+	/* Accelerometer FIFO holds more than one ADC block at 100 Hz */
+	LIS3DSH_Init(LIS3DSH_ODR_100Hz, LIS3DSH_Scale_2G);
+	RESAMPLE_Design_q15(ACC_coeffs, ACC_RESAMPLE_TAPS, ACC_RESAMPLE_L, ACC_RESAMPLE_M);
+	for (i = 0; i < 3; i++) {
+		RESAMPLE_Init(&ACC_resample[i], ACC_RESAMPLE_L, ACC_RESAMPLE_M, ACC_RESAMPLE_TAPS, ACC_coeffs, ACC_branches, ACC_state[i], LIS3DSH_FIFO_SIZE);
+	}
+	FUSION_Init(&Fusion, (float32_t)FUSION_DECIMATION / ADC_SAMPLE_RATE, 6e-4f, 1e-6f, 2.5e-5f);
+	HRV_Init(&Hrv, (float32_t)ADC_SAMPLE_RATE / FUSION_DECIMATION);
+	RESP_Init(&Resp, ADC_SAMPLE_RATE);
+	DTW_Init(&Gesture);
+	PEDO_Init(&Pedo, ACC_SAMPLE_RATE, LIS3DSH_GetSensitivity());
+	FALL_Init(&Fall, ACC_SAMPLE_RATE, LIS3DSH_GetSensitivity());
+	
+	/* Use preemption, accelerometer interrupt with fall detection preempts ADC DMA and TIM2 */
+	HAL_NVIC_SetPriorityGrouping(NVIC_PRIORITYGROUP_4);
+	HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, 1, 0);
+	HAL_NVIC_SetPriority(TIM2_IRQn, 1, 0);
+	LIS3DSH_EnableInterrupt();
+	NRF24L01_EnableInterrupt();
 	
-	HAL_ADC_Start_DMA(&hadc1,(uint32_t*)&ADC_value,1024);
+	HAL_ADC_Start_DMA(&hadc1,(uint32_t*)&ADC_value,ADC_BUFFER_SIZE);
 	HAL_TIM_Base_Start(&htim2);
 
   /* USER CODE END 2 */
@@ -136,40 +252,146 @@ int main(void)
   /* USER CODE END WHILE */
 
   /* USER CODE BEGIN 3 */
-			/* Fill data with something */
-			sprintf((char *)dataOut, "abcdefghij");
-			/* Transmit data, goes automatically to TX mode */
-			NRF24L01_Transmit(dataOut);
-			/* Turn on led to indicate sending */
-			DISCO_LedOn(LED_GREEN);
+			/* Condition last ADC half-block */
+			if (ADC_ready != NULL) {
+				__IO uint16_t* block = ADC_ready;
+				ADC_ready = NULL;
+				
+				start = PROF_Start();
+				SIGCOND_ResetStats(&ADC_stats);
+				SIGCOND_Process(&ADC_cond, (const uint16_t *)block, ADC_block, ADC_BLOCK_SIZE, &ADC_stats);
+				PROF_Stop(PROF_Stage_Cond, start);
+				
+				start = PROF_Start();
+				SQI_Assess_q15(ADC_block, ADC_BLOCK_SIZE, &ADC_stats, &Sqi);
+				PROF_Stop(PROF_Stage_Sqi, start);
+				
+				/* Buffer is drained for bad blocks too, so it holds samples of the next block only */
+				ACC_count = LIS3DSH_ReadBuffer(ACC_fifo, LIS3DSH_FIFO_SIZE);
+				
+				/* Gestures do not depend on optical signal quality */
+				start = PROF_Start();
+				gesture = DTW_Process(&Gesture, ACC_fifo, ACC_count);
+				if (gesture != DTW_NONE) {
+					GestureId = gesture;
+				}
+				PROF_Stop(PROF_Stage_Gesture, start);
+				
+				start = PROF_Start();
+				PEDO_Process(&Pedo, ACC_fifo, ACC_count);
+				PROF_Stop(PROF_Stage_Steps, start);
+				
+				if (SQI_IsGood(&Sqi)) {
+					/* Remove motion artifacts using accelerometer samples from the same period */
+					start = PROF_Start();
+					ACC_commonCount = ACC_Resample(ACC_fifo, ACC_count, ACC_common);
+					PROF_Stop(PROF_Stage_Resample, start);
+					
+					start = PROF_Start();
+					FUSION_Process(&Fusion, ADC_block, ADC_BLOCK_SIZE, ACC_common, ACC_commonCount, FUSION_out);
+					PROF_Stop(PROF_Stage_Fusion, start);
+					
+					start = PROF_Start();
+					HRV_Process(&Hrv, FUSION_out, ADC_BLOCK_SIZE / FUSION_DECIMATION);
+					PROF_Stop(PROF_Stage_Hrv, start);
+					
+					start = PROF_Start();
+					RESP_Process_q15(&Resp, ADC_block, ADC_BLOCK_SIZE);
+					PROF_Stop(PROF_Stage_Resp, start);
+				} else {
+					/* Bad block is not worth processing */
+					PROF_Skip(PROF_Stage_Resample);
+					PROF_Skip(PROF_Stage_Fusion);
+					PROF_Skip(PROF_Stage_Hrv);
+					PROF_Skip(PROF_Stage_Resp);
+				}
+				
+				if (Sqi.Flags != SqiReported) {
+					SqiReported = Sqi.Flags;
+					SqiPending = Sqi.Flags != 0;
+				}
+			}
 			
-			/* Wait for data to be sent */
-			do {
-				/* Get transmission status */
-				transmissionStatus = NRF24L01_GetTransmissionStatus();
-				DISCO_LedOn(LED_BLUE);
-			} while (transmissionStatus == NRF24L01_Transmit_Status_Sending);
-
-			DISCO_LedOn(LED_RED);
-			/* Go back to RX mode */
-			NRF24L01_PowerUpRx();
-			DISCO_LedOn(LED_ORANGE);
+			/* Finish radio mode transition whose settling time has elapsed */
+			NRF24L01_Process();
 			
-			/* Check transmit status */
-			if (transmissionStatus == NRF24L01_Transmit_Status_Ok) {
-				/* Transmit went OK */
-				//USART_Puts(USART1, ": OK\n");
-			} else if (transmissionStatus == NRF24L01_Transmit_Status_Lost) {
+			/* Radio streams queued packets on its own, results come as events from IRQ pin */
+			events = NRF24L01_GetEvents();
+			if (events & NRF24L01_IRQ_MAX_RT) {
 				/* Message was LOST */
-				//USART_Puts(USART1, ": LOST\n");
+				transmissionStatus = NRF24L01_Transmit_Status_Lost;
+				DISCO_LedOn(LED_RED);
+			} else if (events & NRF24L01_IRQ_TRAN_OK) {
+				/* Transmit went OK */
+				transmissionStatus = NRF24L01_Transmit_Status_Ok;
+				DISCO_LedOff(LED_RED);
+			}
+			if (NRF24L01_SendPending() == 0) {
+				DISCO_LedOff(LED_GREEN);
+			}
+			
+			/* Messages from gateway received in RX mode. Driver also queues acknowledgment payloads here,
+			   but bracelet never calls NRF24L01_SetAckPayload(), so EN_ACK_PAY stays off and none arrive */
+			while (NRF24L01_Receive(dataIn, sizeof(dataIn))) {
+				DISCO_LedToggle(LED_ORANGE);
+			}
+			
+			if (FALL_GetAlert(&Fall)) {
+				/* Fall alert takes precedence over everything else, it jumps queue even when queue is full */
+				FALL_Pack(&Fall, dataOut);
+				NRF24L01_SendUrgent(dataOut, sizeof(dataOut));
+				DISCO_LedOn(LED_GREEN);
+			}
+			
+			/* Fall alert above is checked before radio is reserved, so it goes out during scan and waits */
+			if (HOP_Process(&Hop) || LINK_Process(&Link)) {
+				/* Radio is reserved for channel scan, hop or data rate change, nothing is queued.
+				   While announcement waits for acknowledgment sleep until radio interrupt */
+				if (NRF24L01_SendPending()) {
+					__WFI();
+				}
+				continue;
+			}
+			
+			if (NRF24L01_SendSpace() == 0) {
+				/* Queue is full, sleep until radio, DMA, accelerometer or 1 ms SysTick interrupt */
+				__WFI();
+				continue;
+			}
+			
+			if (HOP_GetAnnounce(&Hop, dataOut)) {
+				/* Fill data with new channel, radio hops when it is acknowledged */
+			} else if (LINK_GetAnnounce(&Link, dataOut)) {
+				/* Fill data with new data rate, radio changes it when it is acknowledged */
+			} else if (SqiPending) {
+				/* Fill data with bad signal marker */
+				SqiPending = 0;
+				SQI_Pack(&Sqi, dataOut);
+			} else if (GestureId != DTW_NONE) {
+				/* Fill data with recognized gesture */
+				DTW_Pack(&Gesture, GestureId, dataOut);
+				GestureId = DTW_NONE;
+			} else if (PEDO_GetSummary(&Pedo, &PedoSummary)) {
+				/* Fill data with step count */
+				PEDO_Pack(&PedoSummary, dataOut);
+			} else if (LINK_GetSummary(&Link, &LinkSummary)) {
+				/* Fill data with link statistics */
+				LINK_Pack(&LinkSummary, dataOut);
+			} else if (FUSION_IsReliable(&Fusion) && HRV_GetSummary(&Hrv, &HrvSummary)) {
+				/* Fill data with HRV summary */
+				HRV_Pack(&HrvSummary, dataOut);
 			} else {
-				/* This should never happen */
-				//USART_Puts(USART1, ": SENDING\n");
+				/* Do not send data while signal is corrupted by motion, summary waits for good signal.
+				   Sleep until next interrupt. SysTick keeps running for HAL_GetTick(), so core wakes
+				   at least every 1 ms, not only when DMA delivers next block */
+				__WFI();
+				continue;
 			}
-			DISCO_LedOff(LED_GREEN);
-			DISCO_LedOff(LED_BLUE);
-			DISCO_LedOff(LED_RED);
-			DISCO_LedOff(LED_ORANGE);
+			
+			/* Queue data, radio goes to TX mode and back to RX mode when queue is empty */
+			NRF24L01_Send(dataOut, sizeof(dataOut));
+			/* Turn on led to indicate sending */
+			DISCO_LedOn(LED_GREEN);
 			
 		}
 		
@@ -216,6 +438,48 @@ void SystemClock_Config(void)
 }
 
 /* USER CODE BEGIN 4 */
+uint32_t ACC_Resample(const LIS3DSH_Axes_t* in, uint32_t count, LIS3DSH_Axes_t* out) {
+	q15_t axisIn[LIS3DSH_FIFO_SIZE], axisOut[ACC_COMMON_MAX];
+	uint32_t a, i, n = 0;
+	
+	/* Axes structure is three int16_t values, process one axis at a time */
+	for (a = 0; a < 3; a++) {
+		for (i = 0; i < count; i++) {
+			axisIn[i] = ((const int16_t *)&in[i])[a];
+		}
+		n = RESAMPLE_Process_q15(&ACC_resample[a], axisIn, axisOut, count);
+		for (i = 0; i < n; i++) {
+			((int16_t *)&out[i])[a] = axisOut[i];
+		}
+	}
+	
+	return n;
+}
+
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef* hadc) {
+	/* First half is complete, DMA continues with second one */
+	ADC_ready = &ADC_value[0];
+}
+
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc) {
+	/* Second half is complete, DMA wraps to first one */
+	ADC_ready = &ADC_value[ADC_BLOCK_SIZE];
+}
+
+void EXTI_Handler(uint16_t GPIO_Pin) {
+	if (GPIO_Pin == LIS3DSH_INT1_PIN) {
+		/* Accelerometer data ready */
+		LIS3DSH_IRQHandler();
+	} else if (GPIO_Pin == NRF24L01_IRQ_PIN) {
+		/* Radio transmitted, lost or received packet */
+		NRF24L01_IRQHandler();
+	}
+}
+
+void LIS3DSH_SamplesCallback(const LIS3DSH_Axes_t* axes, uint8_t count) {
+	/* Detect fall as soon as sample is available */
+	FALL_Process(&Fall, axes, count);
+}
 
 /* USER CODE END 4 */
 